@@ -0,0 +1,55 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include <Eigen/Eigen>
+
+namespace linear_system
+{
+
+/**
+ * @brief Runs the same filter over many independent input trajectories (scenarios) at once.
+ *
+ * Scenarios are processed in blocks whose states stay in cache for the whole run, and each
+ * step of the recursion is a handful of vector operations across the scenarios of a block;
+ * blocks are split across threads.
+ * @param realization The filter, started at rest.
+ * @param input A (scenarios by N) matrix whose i-th row holds the N input samples of the
+ * i-th scenario.
+ * @param n_threads Number of threads to split the scenarios across, 0 to use every hardware thread.
+ * @return A (scenarios by N) matrix holding the outputs, row by row.
+ */
+Eigen::MatrixXd simulateBatch(const DiscreteRealization &realization, const Eigen::MatrixXd &input,
+    unsigned int n_threads = 1);
+
+/**
+ * @brief Same as above, starting each scenario from its own state.
+ * @param initial_state A (scenarios by #DiscreteRealization::getOrder) matrix where each row holds
+ * the initial state of the i-th scenario, as in #LinearSystem::setState.
+ */
+Eigen::MatrixXd simulateBatch(const DiscreteRealization &realization, const Eigen::MatrixXd &input,
+    const Eigen::MatrixXd &initial_state, unsigned int n_threads = 1);
+
+/**
+ * @brief Runs a filter over one long input, splitting it in time across threads.
+ *
+ * The recursion x[k+1] = A x[k] + B u[k] composes affine maps: over a segment of L samples
+ * it is x -> A^L x + z, where z is the final state reached from rest. Each thread first
+ * computes z for its segment, the segment boundaries are then fixed by composing these
+ * maps in order, and each thread finally reruns its segment from its exact initial state.
+ * This does about twice the work of a sequential run, so the speedup is about half the
+ * number of threads; short inputs run sequentially.
+ * @param realization The filter, started at rest.
+ * @param input The N input samples.
+ * @param n_threads Number of threads to split the input across, 0 to use every hardware thread.
+ * @return The N outputs.
+ */
+Eigen::VectorXd simulateParallelInTime(const DiscreteRealization &realization, const Eigen::VectorXd &input,
+    unsigned int n_threads = 1);
+
+/**
+ * @brief Same as above, starting from \p initial_state, as in #LinearSystem::setState.
+ */
+Eigen::VectorXd simulateParallelInTime(const DiscreteRealization &realization, const Eigen::VectorXd &input,
+    const Eigen::VectorXd &initial_state, unsigned int n_threads = 1);
+
+}
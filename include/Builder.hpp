@@ -2,6 +2,8 @@
 
 
 #include "LinearSystem.hpp"
+#include "Decimator.hpp"
+#include "CoefficientBank.hpp"
 
 
 namespace linear_system
@@ -14,6 +16,9 @@ namespace linear_system
 class Builder
 {
 public:
+    /*! @brief Sampling period (in seconds) of the filters, and default one of the banks */
+    static constexpr double default_sampling = 0.001;
+
     /**
      * @brief Returns a second order filter with prescribed damping and cutoff frequency.
      * @param damp Damping coefficient.
@@ -46,6 +51,59 @@ public:
      * @return The reference filter.
      */
     static LinearSystem createReferenceFilterI(double kp, double ki);
+
+    /**
+     * @brief Returns a decimator preceded by a second-order Butterworth anti-aliasing filter
+     * whose cutoff frequency is 80% of the output Nyquist frequency.
+     * @param factor Decimation factor.
+     * @param ts Input sampling period.
+     * @return The decimator.
+     */
+    static Decimator createDecimator(unsigned int factor, double ts);
+
+    /**
+     * @brief Returns a decimator that averages the last \p factor input samples, which
+     * runs on the FIR (polyphase-style) path.
+     * @param factor Decimation factor and averaging length.
+     * @param ts Input sampling period.
+     * @return The decimator.
+     */
+    static Decimator createMovingAverageDecimator(unsigned int factor, double ts);
+
+    /**
+     * @brief Returns a bank of the filters of #createSecondOrder, one per pair of parameters.
+     * @param damp Damping coefficient of each filter.
+     * @param cutoff Cutoff frequency of each filter.
+     * @param ts Sampling period.
+     * @return The bank.
+     */
+    static CoefficientBank createSecondOrderBank(const Eigen::VectorXd &damp, const Eigen::VectorXd &cutoff,
+        double ts = default_sampling);
+
+    /**
+     * @brief Returns a bank of the filters of #createReferenceFilter2I(kp, ki, kd), one per
+     * triplet of gains.
+     * @param ts Sampling period.
+     * @return The bank.
+     */
+    static CoefficientBank createReferenceFilter2IBank(const Eigen::VectorXd &kp, const Eigen::VectorXd &ki,
+        const Eigen::VectorXd &kd, double ts = default_sampling);
+
+    /**
+     * @brief Returns a bank of the filters of #createReferenceFilter2I(kp, kd), one per pair of gains.
+     * @param ts Sampling period.
+     * @return The bank.
+     */
+    static CoefficientBank createReferenceFilter2IBank(const Eigen::VectorXd &kp, const Eigen::VectorXd &kd,
+        double ts = default_sampling);
+
+    /**
+     * @brief Returns a bank of the filters of #createReferenceFilterI, one per pair of gains.
+     * @param ts Sampling period.
+     * @return The bank.
+     */
+    static CoefficientBank createReferenceFilterIBank(const Eigen::VectorXd &kp, const Eigen::VectorXd &ki,
+        double ts = default_sampling);
 };
 
 
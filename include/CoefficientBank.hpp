@@ -0,0 +1,123 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include "FilterArena.hpp"
+#include "PerfEvents.hpp"
+#include <Eigen/Eigen>
+#include <memory>
+#include <vector>
+
+namespace linear_system
+{
+
+/*!
+ * \brief The CoefficientBank class runs many filters of the same order, each with its own
+ * coefficients.
+ *
+ * Where #LinearSystem and #FilterBank run copies of one filter, every filter of a bank may
+ * have a different design, as long as they share the order and the sampling period. The
+ * coefficients are stored like the states, one column per coefficient and one row per
+ * filter, so every step is a few element-wise vector operations across filters.
+ *
+ * Banks are usually created in one call by the vectorized methods of #Builder.
+ */
+class CoefficientBank
+{
+private:
+    struct Entry
+    {
+        unsigned int row, col;
+    };
+
+    std::vector<std::shared_ptr<const DiscreteRealization> > realizations;
+
+    /*! @brief Entries of A that are nonzero for at least one filter */
+    std::vector<Entry> a_entries;
+
+    /*! @brief (n_filters by a_entries) values of A */
+    Eigen::MatrixXd a_values;
+
+    /*! @brief (n_filters by order) values of B and C */
+    Eigen::MatrixXd B;
+    Eigen::MatrixXd C;
+    Eigen::VectorXd D;
+
+    /*! @brief (n_filters by order) states */
+    ArenaMatrix<double> state;
+    ArenaMatrix<double> next;
+
+    double Ts;
+
+    std::shared_ptr<PerfProfile> profile;
+
+    CoefficientBank(const std::vector<std::shared_ptr<const DiscreteRealization> > &realizations, FilterArena *arena);
+
+public:
+    /**
+     * @brief Constructs a bank at rest.
+     * @param realizations One design per filter, all of the same order and sampling period.
+     */
+    explicit CoefficientBank(const std::vector<std::shared_ptr<const DiscreteRealization> > &realizations);
+
+    /**
+     * @brief Constructs a bank at rest, whose states are stored in \p arena.
+     *
+     * The arena must outlive the bank; copies of the bank store their states on the heap.
+     * @param realizations One design per filter, all of the same order and sampling period.
+     * @param arena The arena providing storage for the states.
+     */
+    CoefficientBank(const std::vector<std::shared_ptr<const DiscreteRealization> > &realizations, FilterArena &arena);
+
+    /**
+     * @brief Advances every filter by one sample period.
+     * @param input One input per filter.
+     * @param output Receives one output per filter, computed before the states advance; may be
+     * \p input itself.
+     */
+    void update(const Eigen::Ref<const Eigen::VectorXd> &input, Eigen::Ref<Eigen::VectorXd> output);
+
+    /**
+     * @brief Runs every filter over a block of inputs.
+     * @param input A (#getNFilters by K) matrix whose columns are consecutive input samples.
+     * @param output Receives the (#getNFilters by K) outputs.
+     */
+    void process(const Eigen::MatrixXd &input, Eigen::MatrixXd &output);
+
+    /** @brief Zeroes the states. */
+    inline void reset() {state.matrix().setZero();}
+
+    /**
+     * @brief Returns a (#getNFilters by order) matrix where each row holds the state of a filter.
+     */
+    inline Eigen::MatrixXd getState() const {return state.matrix();}
+
+    /**
+     * @brief Forces the states, with the layout of #getState.
+     */
+    void setState(const Eigen::MatrixXd &state);
+
+    inline unsigned int getNFilters() const {return state.matrix().rows();}
+    inline unsigned int getOrder() const {return state.matrix().cols();}
+    inline double getSampling() const {return Ts;}
+
+    /**
+     * @brief Returns the arena holding the states, or nullptr if they live on the heap.
+     */
+    inline FilterArena * getArena() const {return state.getArena();}
+
+    /** @brief Returns the design of filter \p i. */
+    inline const std::shared_ptr<const DiscreteRealization> & getRealization(unsigned int i) const
+    {
+        return realizations.at(i);
+    }
+
+    /**
+     * @brief Attaches a profile collecting the hardware counters of #update (one call per
+     * sample), which may be shared with other banks. Only collects when the library is compiled
+     * with LINEAR_SYSTEM_PERF_EVENTS.
+     */
+    inline void setProfile(std::shared_ptr<PerfProfile> profile) {this->profile = std::move(profile);}
+    inline const std::shared_ptr<PerfProfile> & getProfile() const {return profile;}
+};
+
+}
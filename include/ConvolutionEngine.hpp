@@ -0,0 +1,110 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include "FilterBank.hpp"
+#include <Eigen/Eigen>
+#include <memory>
+
+namespace linear_system
+{
+
+/*!
+ * \brief How a #ConvolutionEngine computes its outputs.
+ */
+enum ConvolutionMode
+{
+    /*! Picks the cheapest of the two others from the filter and the block size */
+    AUTOMATIC,
+    /*! Runs the state-space recursion, like #FilterBank */
+    RECURRENCE,
+    /*! Convolves the inputs with the truncated impulse response by partitioned FFTs */
+    OVERLAP_SAVE
+};
+
+/*!
+ * \brief The ConvolutionEngine class runs many identical filters on blocks of samples, either
+ * with the state-space recursion or by FFT convolution with their truncated impulse response.
+ *
+ * The recursion costs O(order) per sample, which dominates for long FIR filters and for
+ * high-order filters approximating long impulse responses. The FFT path uses a uniformly
+ * partitioned overlap-save: the impulse response is cut into partitions of one block, and
+ * each block of input costs one forward and one inverse FFT of twice the block size plus one
+ * spectrum product per partition, whatever the order.
+ *
+ * Outputs are aligned with the inputs (there is no added latency), and filters start at rest.
+ */
+class ConvolutionEngine
+{
+private:
+    struct Partitions;
+
+    std::shared_ptr<const DiscreteRealization> realization;
+    unsigned int n_filters;
+    unsigned int block_size;
+    ConvolutionMode mode;
+
+    /*! @brief Length of the truncated impulse response, 0 on the recursion path */
+    unsigned int impulse_length;
+
+    std::unique_ptr<DoubleFilterBank> recurrence;
+    std::unique_ptr<Partitions> partitions;
+
+public:
+    /**
+     * @brief Constructs \p n_filters filters at rest.
+     * @param realization The filter to run; it must be stable unless the recursion is forced.
+     * @param n_filters Number of filters.
+     * @param block_size Number of samples per block, which must be even on the FFT path.
+     * @param mode Forces one of the paths, or selects it automatically.
+     * @param tolerance The impulse response is truncated once the L2 norm of its remaining
+     * samples falls below \p tolerance times its L1 norm; see #impulseResponse.
+     */
+    ConvolutionEngine(std::shared_ptr<const DiscreteRealization> realization, unsigned int n_filters,
+        unsigned int block_size, ConvolutionMode mode = AUTOMATIC, double tolerance = 1e-12);
+
+    ~ConvolutionEngine();
+
+    /**
+     * @brief Runs every filter over whole blocks of inputs.
+     * @param input A (#getNFilters by K) matrix whose columns are consecutive input samples,
+     * with K a multiple of #getBlockSize.
+     * @param output Receives the (#getNFilters by K) outputs.
+     */
+    void process(const Eigen::MatrixXd &input, Eigen::MatrixXd &output);
+
+    /** @brief Puts every filter back at rest. */
+    void reset();
+
+    /**
+     * @brief Returns the impulse response of \p realization, truncated once the L2 norm of its
+     * remaining samples falls below \p tolerance times its L1 norm.
+     *
+     * The energy of the remaining samples is x' Q x, with x the state after the impulse and Q
+     * the observability Gramian, so that the bound holds for lightly damped and non-normal
+     * realizations alike, and every dropped sample is below \p tolerance times the L1 norm.
+     *
+     * Throws if the filter is not stable, or if the response is not truncated within
+     * \p max_length samples.
+     */
+    static Eigen::VectorXd impulseResponse(const DiscreteRealization &realization, double tolerance,
+        unsigned int max_length = 1u << 22);
+
+    /**
+     * @brief Returns the cheapest path for a filter whose impulse response has
+     * \p impulse_length samples, run on blocks of \p block_size samples.
+     *
+     * The costs are estimated multiply-adds per output: the nonzero coefficients of the
+     * realization for the recursion, and the two transforms plus one complex product per
+     * partition and frequency bin for the FFTs.
+     */
+    static ConvolutionMode selectMode(const DiscreteRealization &realization, unsigned int impulse_length,
+        unsigned int block_size);
+
+    inline ConvolutionMode getMode() const {return mode;}
+    inline unsigned int getImpulseLength() const {return impulse_length;}
+    inline unsigned int getBlockSize() const {return block_size;}
+    inline unsigned int getNFilters() const {return n_filters;}
+    inline const std::shared_ptr<const DiscreteRealization> & getRealization() const {return realization;}
+};
+
+}
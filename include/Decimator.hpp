@@ -0,0 +1,110 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include "FilterState.hpp"
+#include <Eigen/Eigen>
+#include <memory>
+
+namespace linear_system
+{
+
+/*!
+ * \brief The Decimator class runs multiple identical filters at the input rate but only
+ * computes their outputs at 1/M of it.
+ *
+ * The states advance on every input sample, while y = Cx + Du is evaluated only on every
+ * M-th one. Filters with a finite impulse response skip the state-space recursion altogether:
+ * they keep the last N+1 inputs and evaluate the convolution only when an output is due, so
+ * the cost per input sample drops to a store plus (N+1)/M multiply-adds.
+ *
+ * Unlike #LinearSystem, a decimator is driven sample by sample, without timestamps.
+ */
+class Decimator
+{
+private:
+    std::shared_ptr<const DiscreteRealization> realization;
+
+    /*! @brief States and last outputs, used by the state-space path */
+    FilterState fstate;
+
+    /*! @brief Last computed output of either path, returned by #getOutput */
+    Output last_output;
+
+    /*!
+     * \brief Input history of the FIR path, (n_filters by 2(N+1))
+     *
+     * Every sample is stored twice, N+1 columns apart, so the last N+1 inputs are always
+     * available as one contiguous block.
+     */
+    Eigen::MatrixXd history;
+
+    /*! @brief FIR coefficients in the order of the history, oldest input first */
+    Eigen::VectorXd taps;
+
+    /*! @brief Column of the history where the next input goes */
+    unsigned int position;
+
+    /*! @brief Decimation factor */
+    unsigned int factor;
+
+    /*! @brief Input samples to go before the next output */
+    unsigned int countdown;
+
+    unsigned int n_filters;
+    bool fir;
+
+    /*! @brief Buffer for one column of the input in #process */
+    Input sample;
+
+public:
+    /**
+     * @brief Constructor.
+     * @param realization The filter to run at the input rate.
+     * @param factor Decimation factor M, at least 1.
+     * @param n_filters Number of identical filters (input channels).
+     */
+    Decimator(std::shared_ptr<const DiscreteRealization> realization, unsigned int factor, unsigned int n_filters = 1);
+
+    /**
+     * @brief Zeroes the states and makes the next input sample produce an output.
+     */
+    void reset();
+
+    /**
+     * @brief Feeds one input sample to every filter.
+     * @param signalIn input signals, one per filter.
+     * @return true if an output was computed, which is then available through #getOutput.
+     */
+    bool update(const Input &signalIn);
+
+    /**
+     * @brief Feeds a block of input samples to every filter.
+     * @param input A (#getNFilters by K) matrix whose columns are consecutive input samples.
+     * @param output Receives one column per computed output; its storage is reused when the
+     * size does not change.
+     * @return The number of outputs computed.
+     */
+    unsigned int process(const Eigen::MatrixXd &input, Eigen::MatrixXd &output);
+
+    /**
+     * @brief Returns the last computed output.
+     */
+    inline const Output & getOutput() const {return last_output;}
+
+    inline unsigned int getFactor() const {return factor;}
+    inline unsigned int getNFilters() const {return n_filters;}
+
+    /**
+     * @brief Returns the sampling period of the outputs, in seconds.
+     */
+    inline double getOutputSampling() const {return factor * realization->getSampling();}
+
+    /**
+     * @brief Whether the FIR (polyphase-style) path is used.
+     */
+    inline bool isPolyphase() const {return fir;}
+
+    inline const std::shared_ptr<const DiscreteRealization> & getRealization() const {return realization;}
+};
+
+}
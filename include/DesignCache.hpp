@@ -0,0 +1,85 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+namespace linear_system
+{
+
+/*!
+ * \brief Thread-safe cache of discrete filter designs.
+ *
+ * Designs are keyed on the normalized continuous-time coefficients, the sampling period,
+ * the integration method, the prewarp frequency and the realization form. Filters built from the same parameters
+ * share one immutable #DiscreteRealization, which is released once no filter holds it anymore.
+ */
+class DesignCache
+{
+private:
+    struct Key
+    {
+        std::vector<double> num;
+        std::vector<double> den;
+        double ts;
+        IntegrationMethod method;
+        double prewarp;
+        RealizationForm form;
+
+        bool operator<(const Key &other) const;
+    };
+
+    std::map<Key, std::weak_ptr<const DiscreteRealization> > designs;
+
+    /*! @brief Size of #designs that triggers the next removal of expired entries */
+    std::size_t sweep_size;
+
+    std::mutex mutex;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+
+    DesignCache();
+
+public:
+    /**
+     * @brief Returns the process-wide cache.
+     */
+    static DesignCache & instance();
+
+    /**
+     * @brief Returns the discrete design for the given parameters, building it only if no
+     * live filter already uses an identical one.
+     *
+     * The parameters have the same meaning as in #DiscreteRealization's constructor.
+     */
+    std::shared_ptr<const DiscreteRealization> get(const Poly &num, const Poly &den, double ts,
+        IntegrationMethod method, double prewarp, RealizationForm form = CONTROLLABLE_CANONICAL);
+
+    /**
+     * @brief Returns the number of requests served by an existing design.
+     */
+    inline uint64_t getHits() const {return hits;}
+
+    /**
+     * @brief Returns the number of requests that required a new design.
+     */
+    inline uint64_t getMisses() const {return misses;}
+
+    /**
+     * @brief Returns the number of designs currently in use.
+     */
+    std::size_t size();
+
+    /**
+     * @brief Forgets every design and resets the hit/miss counters.
+     *
+     * Filters keep the designs they already hold.
+     */
+    void clear();
+};
+
+}
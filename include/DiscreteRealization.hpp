@@ -0,0 +1,289 @@
+#pragma once
+
+#include "FilterState.hpp"
+#include <Eigen/Eigen>
+#include <memory>
+#include <vector>
+
+namespace linear_system
+{
+
+enum IntegrationMethod
+{
+    FORWARD_EULER,
+    BACKWARD_EULER,
+    TUSTIN,
+    /*! @brief Exact discretization assuming the input is held constant between samples */
+    ZOH,
+    /*! @brief Exact discretization assuming the input is linearly interpolated between samples */
+    FOH,
+    /*! @brief Discrete impulse response equal to Ts times the sampled continuous one */
+    IMPULSE_INVARIANT,
+    /*! @brief Coefficients given directly in discrete time, there is no continuous-time model */
+    DIRECT
+};
+
+/*!
+ * \brief State coordinates of the realization (A,B,C,D) of a filter; every form has the same
+ * transfer function, but not the same numerical behavior.
+ */
+enum RealizationForm
+{
+    /*!
+     * @brief Companion matrix built from the transfer function coefficients (for the hold-equivalent
+     * methods, the discretization of the continuous-time one)
+     */
+    CONTROLLABLE_CANONICAL,
+    /*!
+     * @brief Block-diagonal A with a 1x1 block per real pole and a real 2x2 block per pair
+     * of complex poles, which makes the update O(N); requires distinct poles
+     */
+    MODAL,
+    /*! @brief Equal and diagonal controllability and observability Gramians; requires a stable filter */
+    BALANCED,
+    /*!
+     * @brief The (A,B,C,D) given to the state-space constructor, kept as is, such as the
+     * block-triangular realization of an interconnection of filters
+     */
+    STATE_SPACE
+};
+
+typedef Eigen::VectorXd Poly;
+
+/*!
+ * \brief The DiscreteRealization class holds the discrete-time transfer function and
+ * state-space realization (A,B,C,D) of a SISO filter.
+ *
+ * Instances are immutable once built, so a single realization can be shared by any
+ * number of filters (see #DesignCache).
+ */
+class DiscreteRealization
+{
+private:
+    //SS realization
+    Eigen::MatrixXd A;
+    Eigen::VectorXd B;
+    Eigen::RowVectorXd C;
+    double D;
+
+    unsigned int order;
+
+    /*! @brief Continuous-time numerator, monic-normalized and padded to the denominator size (empty for #DIRECT) */
+    Poly cont_num;
+
+    /*! @brief Continuous-time denominator, monic-normalized (empty for #DIRECT) */
+    Poly cont_den;
+
+    /*! @brief Discrete-time numerator tfNum[0] z^N + tfNum[1] z^(N-1) + ... + tfNum[N] */
+    Poly tf_num;
+
+    /*! @brief Discrete-time denominator tfDen[0] z^N + tfDen[1] z^(N-1) + ... + tfDen[N] */
+    Poly tf_den;
+
+    /*! @brief Sampling period (in seconds) */
+    double Ts;
+
+    /*! @brief Integration method */
+    IntegrationMethod integration_method;
+
+    /*! @brief Prewarp frequency (in rad/s), only nonzero with Tustin's method */
+    double prewarp_frequency;
+
+    RealizationForm form;
+
+    /*! @brief Sizes (1 or 2) of the diagonal blocks of A, in the #MODAL form */
+    std::vector<unsigned int> mode_sizes;
+
+    /*!
+     * \brief Transforms the filter to discrete time.
+     */
+    void discretize();
+
+    /**
+     * @brief Converts the polynomial \p poly from continuous-time do discrete-time using
+     * the forward Euler approximation
+     */
+    void convertFwdEuler(Poly & poly) const;
+
+    /**
+     * @brief Converts the polynomial \p poly from continuous-time do discrete-time using
+     * the backward Euler approximation
+     */
+    void convertBwdEuler(Poly & poly) const;
+
+    /**
+     * @brief Converts the polynomial \p poly from continuous-time do discrete-time using
+     * the Tustin approximation
+     */
+    void convertTustin(Poly & poly) const;
+
+    /*!
+     * \brief Computes the state-space realization (A,B,C,D)
+     */
+    void tf2ss();
+
+    /*!
+     * \brief Computes the discrete realization from the matrix exponential of the
+     * continuous-time realization, for the hold-equivalent methods (ZOH, FOH and
+     * impulse invariance), and then the discrete transfer function from it.
+     *
+     * \see MIMORealization::discretize
+     */
+    void discretizeExact();
+
+    /*!
+     * \brief Replaces the realization computed by the discretization with one in #form.
+     */
+    void transform();
+
+    /*!
+     * \brief Builds the #MODAL realization.
+     *
+     * The poles and residues come from the continuous-time model when there is one, whose
+     * block-diagonal realization is then discretized; the discrete transfer function of a
+     * high-order filter with a short sampling period has clustered poles that its coefficients
+     * determine very poorly.
+     * \return false, leaving the realization untouched, if the poles are not distinct.
+     */
+    bool toModal();
+
+    /*!
+     * \brief Changes the coordinates of (A,B,C) to the #BALANCED form.
+     */
+    void toBalanced();
+
+public:
+    /*!
+     * \brief Computes the controllable canonical realization (A,B,C,D) of num/den.
+     *
+     * \param num Numerator, with as many coefficients as \p den.
+     * \param den Monic denominator.
+     */
+    static void tf2ss(const Poly &num, const Poly &den, Eigen::MatrixXd &A, Eigen::VectorXd &B,
+        Eigen::RowVectorXd &C, double &D);
+
+    /**
+     * @brief Normalizes the continuous-time coefficients the same way the constructor does:
+     * the denominator is made monic and the numerator is padded with leading zeros
+     * to the denominator size.
+     *
+     * Throws std::logic_error if the coefficients do not describe a proper filter.
+     */
+    static void normalize(const Poly &num, const Poly &den, Poly &norm_num, Poly &norm_den);
+
+    /**
+     * @brief Designs the discrete-time filter.
+     *
+     * With the #DIRECT method, \p num and \p den are taken as discrete-time coefficients
+     * (in z) and the continuous-time coefficients are left empty.
+     * @param num Continuous-time numerator num[0] s^N + ... + num[N].
+     * @param den Continuous-time denominator den[0] s^N + ... + den[N].
+     * @param ts Sampling period (in seconds).
+     * @param method Integration method.
+     * @param prewarp Prewarp frequency to use with Tustin's integration method, 0 to disable it.
+     * @param form State coordinates of the realization.
+     */
+    DiscreteRealization(const Poly &num, const Poly &den, double ts, IntegrationMethod method, double prewarp,
+        RealizationForm form = CONTROLLABLE_CANONICAL);
+
+    /**
+     * @brief Builds a discrete-time filter from its state-space realization.
+     *
+     * The filter is #DIRECT, and its transfer function is computed from (A,B,C,D).
+     * @param ts Sampling period (in seconds).
+     * @param form #STATE_SPACE keeps (A,B,C,D); any other form replaces them with that form.
+     */
+    DiscreteRealization(const Eigen::MatrixXd &A, const Eigen::VectorXd &B, const Eigen::RowVectorXd &C, double D,
+        double ts, RealizationForm form = STATE_SPACE);
+
+    inline const Eigen::MatrixXd & getA() const {return A;}
+    inline const Eigen::VectorXd & getB() const {return B;}
+    inline const Eigen::RowVectorXd & getC() const {return C;}
+    inline double getD() const {return D;}
+
+    /*!
+     * \brief getOrder Returns the filter order
+     */
+    inline unsigned int getOrder() const {return order;}
+
+    /**
+     * @brief Returns the sampling period in seconds.
+     */
+    inline double getSampling() const {return Ts;}
+
+    inline IntegrationMethod getIntegrationMethod() const {return integration_method;}
+    inline double getPrewarpFrequency() const {return prewarp_frequency;}
+    inline RealizationForm getRealizationForm() const {return form;}
+
+    /** @brief Discrete-time numerator coefficients. */
+    inline const Poly & getNumerator() const {return tf_num;}
+
+    /** @brief Discrete-time denominator coefficients. */
+    inline const Poly & getDenominator() const {return tf_den;}
+
+    /** @brief Whether the filter comes from a continuous-time model; false for #DIRECT designs. */
+    inline bool hasContinuousModel() const {return integration_method != DIRECT;}
+
+    /**
+     * @brief Whether the filter has a finite impulse response, i.e. all of its poles are at z = 0.
+     */
+    bool isFIR() const;
+
+    /** @brief Normalized continuous-time numerator coefficients. */
+    inline const Poly & getContinuousNumerator() const {return cont_num;}
+
+    /** @brief Normalized continuous-time denominator coefficients. */
+    inline const Poly & getContinuousDenominator() const {return cont_den;}
+
+    /*!
+     * \brief Updates every filter in \p fstate by one sample period.
+     *
+     * The size of \p signalIn is not checked against the number of filters.
+     *
+     * \param fstate states and last outputs of the filters; the time is left untouched.
+     * \param signalIn input signals, one per filter.
+     */
+    void update(FilterState &fstate, const Input &signalIn) const;
+
+    /*!
+     * \brief Computes the outputs y = Cx + Du of every filter in \p fstate without advancing it.
+     */
+    void output(FilterState &fstate, const Input &signalIn) const;
+
+    /*!
+     * \brief Advances the states x = Ax + Bu of every filter in \p fstate without computing
+     * the outputs.
+     */
+    void advance(FilterState &fstate, const Input &signalIn) const;
+
+    /*!
+     * \brief setInitialState Sets the initial state x[0] of each N-th order filter in \p fstate
+     *
+     * The initial state is computed from:
+     *     u[0], ..., u[-(N-1)], the current and N-1 past input samples
+     *     y[0], dy/dt[0], ..., d^(N-1)y/dt^(N-1)[0], the current output and its N-1 derivatives
+     *
+     * \param fstate filters whose states and last outputs are set; it must already hold one
+     * state row per filter.
+     * \param u_history each i-th row holds u_i[0], ..., u_i[-(N-1)], in this order; that is, the
+     * current input and last N-1 inputs of the i-th input channel
+     * \param initial_output_derivatives Every row contains y[0], dy/dt[0], ...,
+     * d^(N-1)y/dt^(N-1)[0], in this order and each row corresponds to one filter
+     */
+    void setInitialState(FilterState &fstate, const Eigen::MatrixXd &u_history,
+        const Eigen::MatrixXd &initial_output_derivatives) const;
+
+    /*!
+     * \brief Returns the state reached with a unit constant input, (I - A)^-1 B.
+     *
+     * A filter whose inputs have always been u is in the state u (I - A)^-1 B: this is the state
+     * #setInitialState gives when the current and past inputs all equal u, and the output
+     * is H(1) u with zero derivatives. Unlike it, this takes a single solve for any number of
+     * filters, and doesn't need an invertible A, which FIR filters lack.
+     *
+     * Throws std::logic_error if the filter has a pole at z = 1, since there is no steady state.
+     */
+    Eigen::VectorXd unitSteadyState() const;
+};
+
+}
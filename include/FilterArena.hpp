@@ -0,0 +1,168 @@
+#pragma once
+
+#include <Eigen/Eigen>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace linear_system
+{
+
+/*!
+ * \brief Monotonic memory arena for filter states.
+ *
+ * The arena reserves a single block up front and hands out cache-line aligned chunks of it,
+ * so the states of a group of filters end up contiguous in memory and creating them does
+ * not touch the global heap. Allocation is lock-free and may happen from several threads.
+ * Memory is only given back when the arena is destroyed, which must happen after every
+ * filter using it.
+ */
+class FilterArena
+{
+private:
+    char *block;
+    char *begin;
+    std::size_t capacity;
+    std::atomic<std::size_t> used;
+
+    FilterArena(const FilterArena &);
+    FilterArena & operator=(const FilterArena &);
+
+public:
+    /*! @brief Alignment (in bytes) of every chunk handed out by the arena */
+    static const std::size_t alignment = 64;
+
+    /**
+     * @brief Reserves \p capacity bytes.
+     */
+    explicit FilterArena(std::size_t capacity);
+    ~FilterArena();
+
+    /**
+     * @brief Returns room for \p n doubles, aligned to #alignment bytes.
+     *
+     * Throws std::bad_alloc if the arena is exhausted.
+     */
+    double * allocate(std::size_t n);
+
+    /**
+     * @brief Returns the number of bytes handed out so far, including alignment padding.
+     */
+    inline std::size_t getUsed() const {return used;}
+
+    /**
+     * @brief Returns the number of bytes reserved by the arena.
+     */
+    inline std::size_t getCapacity() const {return capacity;}
+};
+
+/*!
+ * \brief A matrix whose storage comes either from the heap or from a #FilterArena given at
+ * construction, used for the state buffers of the filter banks.
+ *
+ * As with #FilterState, copies always use the heap and moves keep the original storage.
+ * Float matrices take their storage from the arena in whole doubles.
+ */
+template<typename Scalar>
+class ArenaMatrix
+{
+public:
+    typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+
+private:
+    /*! @brief Heap storage, unused when the matrix lives in an arena */
+    std::vector<Scalar, Eigen::aligned_allocator<Scalar> > heap_storage;
+
+    FilterArena *arena;
+
+    Eigen::Map<Matrix> values;
+
+    void remap(Scalar *data, Eigen::Index rows, Eigen::Index cols)
+    {
+        new (&values) Eigen::Map<Matrix>(data, rows, cols);
+    }
+
+public:
+    /**
+     * @brief Creates an empty matrix.
+     * @param arena Arena providing the storage, or nullptr to use the heap. The arena must
+     * outlive this matrix.
+     */
+    explicit ArenaMatrix(FilterArena *arena = nullptr) : arena(arena), values(nullptr, 0, 0) {}
+
+    ArenaMatrix(const ArenaMatrix &other) : arena(nullptr), values(nullptr, 0, 0)
+    {
+        *this = other;
+    }
+
+    ArenaMatrix(ArenaMatrix &&other) noexcept :
+        heap_storage(std::move(other.heap_storage)), arena(other.arena), values(nullptr, 0, 0)
+    {
+        remap(other.values.data(), other.values.rows(), other.values.cols());
+        other.remap(nullptr, 0, 0);
+    }
+
+    ArenaMatrix & operator=(const ArenaMatrix &other)
+    {
+        if (this != &other)
+        {
+            if (values.rows() != other.values.rows() || values.cols() != other.values.cols())
+                resize(other.values.rows(), other.values.cols());
+            values = other.values;
+        }
+        return *this;
+    }
+
+    ArenaMatrix & operator=(ArenaMatrix &&other)
+    {
+        // Storage can only be taken over when both matrices draw it from the same place
+        if (arena != other.arena)
+            return *this = static_cast<const ArenaMatrix &>(other);
+        swap(other);
+        return *this;
+    }
+
+    /**
+     * @brief Exchanges the storage of two matrices drawn from the same place, without copying
+     * the values.
+     */
+    void swap(ArenaMatrix &other)
+    {
+        heap_storage.swap(other.heap_storage);
+        Scalar *data = values.data();
+        Eigen::Index rows = values.rows(), cols = values.cols();
+        remap(other.values.data(), other.values.rows(), other.values.cols());
+        other.remap(data, rows, cols);
+    }
+
+    /**
+     * @brief Gives the matrix \p rows by \p cols uninitialized values, taking new storage from
+     * the arena or the heap.
+     */
+    void resize(Eigen::Index rows, Eigen::Index cols)
+    {
+        std::size_t size = rows * cols;
+        Scalar *data;
+        if (arena)
+            data = reinterpret_cast<Scalar *>(arena->allocate((size * sizeof(Scalar) + sizeof(double) - 1) / sizeof(double)));
+        else
+        {
+            heap_storage.resize(size);
+            data = heap_storage.data();
+        }
+        remap(data, rows, cols);
+    }
+
+    /** @brief Returns the values, which can be modified but not resized. */
+    inline Eigen::Map<Matrix> & matrix() {return values;}
+    inline const Eigen::Map<Matrix> & matrix() const {return values;}
+
+    /**
+     * @brief Returns the arena holding this matrix, or nullptr if it lives on the heap.
+     */
+    inline FilterArena * getArena() const {return arena;}
+};
+
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include "FilterArena.hpp"
+#include "MatrixEntries.hpp"
+#include "PerfEvents.hpp"
+#include <Eigen/Eigen>
+#include <memory>
+#include <vector>
+
+namespace linear_system
+{
+
+/*!
+ * \brief The FilterBank class runs many identical filters with a configurable precision.
+ *
+ * The filter is always designed in double precision; its realization is then rounded to
+ * \p State, the type of the states, inputs and outputs. Each step accumulates in \p Accumulator,
+ * so FilterBank<float, double> keeps the memory footprint of float while rounding only once
+ * per state and output. Only float and double are instantiated.
+ *
+ * States are stored like in #LinearSystem, one column per state component, and the update
+ * only visits the nonzero entries of A, so every term is a vector operation across filters.
+ */
+template<typename State, typename Accumulator = State>
+class FilterBank
+{
+public:
+    typedef Eigen::Matrix<State, Eigen::Dynamic, 1> Vector;
+    typedef Eigen::Matrix<State, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+
+private:
+    typedef Eigen::Matrix<Accumulator, Eigen::Dynamic, 1> AccumulatorVector;
+
+    std::shared_ptr<const DiscreteRealization> realization;
+
+    /*! @brief Nonzero entries of A */
+    std::vector<MatrixEntry<Accumulator> > a_entries;
+    std::vector<Accumulator> B;
+    std::vector<Accumulator> C;
+    Accumulator D;
+
+    /*! @brief (n_filters by order) states */
+    ArenaMatrix<State> state;
+
+    /*! @brief Scratch for the input, output and next state, in the accumulator type */
+    AccumulatorVector input_acc;
+    AccumulatorVector output_acc;
+    ArenaMatrix<Accumulator> next;
+
+    std::shared_ptr<PerfProfile> profile;
+
+    FilterBank(std::shared_ptr<const DiscreteRealization> realization, unsigned int n_filters, FilterArena *arena);
+
+public:
+    /**
+     * @brief Constructs \p n_filters filters at rest.
+     * @param realization The (double precision) filter to run.
+     * @param n_filters Number of filters.
+     */
+    FilterBank(std::shared_ptr<const DiscreteRealization> realization, unsigned int n_filters);
+
+    /**
+     * @brief Constructs \p n_filters filters at rest, whose states are stored in \p arena.
+     *
+     * The arena must outlive the bank; copies of the bank store their states on the heap.
+     * @param realization The (double precision) filter to run.
+     * @param n_filters Number of filters.
+     * @param arena The arena providing storage for the states.
+     */
+    FilterBank(std::shared_ptr<const DiscreteRealization> realization, unsigned int n_filters, FilterArena &arena);
+
+    /**
+     * @brief Advances every filter by one sample period.
+     * @param input One input per filter.
+     * @param output Receives one output per filter, computed before the states advance.
+     */
+    void update(const Eigen::Ref<const Vector> &input, Eigen::Ref<Vector> output);
+
+    /**
+     * @brief Runs every filter over a block of inputs.
+     * @param input A (#getNFilters by K) matrix whose columns are consecutive input samples.
+     * @param output Receives the (#getNFilters by K) outputs.
+     */
+    void process(const Matrix &input, Matrix &output);
+
+    /** @brief Zeroes the states. */
+    inline void reset() {state.matrix().setZero();}
+
+    /**
+     * @brief Returns a (#getNFilters by order) matrix where each row holds the state of a filter.
+     */
+    inline Matrix getState() const {return state.matrix();}
+
+    /**
+     * @brief Forces the states, with the layout of #getState.
+     */
+    void setState(const Matrix &state);
+
+    inline unsigned int getNFilters() const {return state.matrix().rows();}
+
+    /**
+     * @brief Returns the arena holding the states, or nullptr if they live on the heap.
+     */
+    inline FilterArena * getArena() const {return state.getArena();}
+    inline const std::shared_ptr<const DiscreteRealization> & getRealization() const {return realization;}
+
+    /**
+     * @brief Attaches a profile collecting the hardware counters of #update (one call per
+     * sample), which may be shared with other banks. Only collects when the library is compiled
+     * with LINEAR_SYSTEM_PERF_EVENTS.
+     */
+    inline void setProfile(std::shared_ptr<PerfProfile> profile) {this->profile = std::move(profile);}
+    inline const std::shared_ptr<PerfProfile> & getProfile() const {return profile;}
+};
+
+typedef FilterBank<double> DoubleFilterBank;
+typedef FilterBank<float> FloatFilterBank;
+
+/*! @brief Single-precision states with double-precision accumulation */
+typedef FilterBank<float, double> MixedFilterBank;
+
+}
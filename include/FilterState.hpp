@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Eigen/Eigen>
+#include <stdint.h>
+#include <vector>
+
+namespace linear_system
+{
+
+class FilterArena;
+
+typedef int64_t Time;
+typedef Eigen::RowVectorXd Input;
+typedef Eigen::VectorXd Output;
+
+/*!
+ * \brief The FilterState struct holds everything that changes while a group of filters runs.
+ *
+ * The coefficients live in a (possibly shared) #DiscreteRealization, so a state is all that
+ * needs to be stored per filter instance.
+ *
+ * The states and last outputs are stored in a single block, which comes either from the
+ * heap or from a #FilterArena given at construction. Copies always use the heap; moves
+ * keep the original storage.
+ */
+struct FilterState
+{
+    /*! @brief States of the state-space in matrix form (numInputs,stateSize) */
+    Eigen::Map<Eigen::MatrixXd> state;
+
+    /*! @brief Last output value */
+    Eigen::Map<Output> last_output;
+
+    /*! @brief Filter current time */
+    Time time;
+
+    /**
+     * @brief Creates an empty state.
+     * @param arena Arena providing the storage, or nullptr to use the heap. The arena must
+     * outlive this state.
+     */
+    explicit FilterState(FilterArena *arena = nullptr);
+
+    FilterState(const FilterState &other);
+    FilterState(FilterState &&other) noexcept;
+
+    /**
+     * @brief Copies the values of \p other, reusing the current storage when the dimensions match.
+     */
+    FilterState & operator=(const FilterState &other);
+    FilterState & operator=(FilterState &&other);
+
+    /*!
+     * \brief Resizes the state for \p n_filters filters of order \p order and zeroes it.
+     *
+     * The current storage is reused when it is large enough.
+     */
+    void reset(unsigned int n_filters, unsigned int order);
+
+    /**
+     * @brief Returns the arena holding this state, or nullptr if it lives on the heap.
+     */
+    inline FilterArena * getArena() const {return arena;}
+
+private:
+    /*! @brief Heap storage, unused when the state lives in an arena */
+    std::vector<double, Eigen::aligned_allocator<double> > heap_storage;
+
+    FilterArena *arena;
+
+    /*! @brief Number of doubles available at #state.data() */
+    std::size_t capacity;
+
+    /*! @brief Points #state and #last_output to \p data */
+    void remap(double *data, Eigen::Index n_filters, Eigen::Index order);
+
+    /*! @brief Number of doubles needed for \p n_filters filters of order \p order */
+    static std::size_t storageSize(Eigen::Index n_filters, Eigen::Index order);
+};
+
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include "DesignCache.hpp"
+#include <memory>
+
+namespace linear_system
+{
+
+/*!
+ * \brief Discrete transfer function of an N-th order filter, as a literal type so that it can
+ * be computed at compile time.
+ *
+ * Coefficients follow the same convention as #DiscreteRealization::getNumerator and
+ * #DiscreteRealization::getDenominator: highest power of z first, monic denominator.
+ */
+template<unsigned int N>
+struct FixedCoefficients
+{
+    double num[N + 1];
+    double den[N + 1];
+
+    /*! @brief Sampling period (in seconds) */
+    double ts;
+};
+
+/*!
+ * \brief Compile-time design of first and second order filters.
+ *
+ * Every function is constexpr, so designs with constant parameters cost nothing at startup:
+ *
+ *     constexpr FixedCoefficients<2> c = design::secondOrder<TUSTIN>(0.7, 10, 0.001);
+ *
+ * Only the methods that substitute s by a rational function of z are available (forward and
+ * backward Euler, and Tustin without prewarping), since the others need tan() or expm().
+ */
+namespace design
+{
+
+namespace detail
+{
+
+// s = (alpha z + beta) / (gamma z + delta)
+template<IntegrationMethod M> struct Substitution;
+
+template<> struct Substitution<FORWARD_EULER>
+{
+    static constexpr double alpha(double) {return 1;}
+    static constexpr double beta(double) {return -1;}
+    static constexpr double gamma(double) {return 0;}
+    static constexpr double delta(double ts) {return ts;}
+};
+
+template<> struct Substitution<BACKWARD_EULER>
+{
+    static constexpr double alpha(double) {return 1;}
+    static constexpr double beta(double) {return -1;}
+    static constexpr double gamma(double ts) {return ts;}
+    static constexpr double delta(double) {return 0;}
+};
+
+template<> struct Substitution<TUSTIN>
+{
+    static constexpr double alpha(double ts) {return 2 / ts;}
+    static constexpr double beta(double ts) {return -2 / ts;}
+    static constexpr double gamma(double) {return 1;}
+    static constexpr double delta(double) {return 1;}
+};
+
+constexpr double sqrtIteration(double x, double guess, int remaining)
+{
+    return remaining == 0 ? guess : sqrtIteration(x, (guess + x / guess) / 2, remaining - 1);
+}
+
+/*! @brief Newton's square root, for values within a few decades of 1 */
+constexpr double sqrt(double x)
+{
+    return x <= 0 ? 0 : sqrtIteration(x, x > 1 ? x : 1, 100);
+}
+
+/*! @brief Same as linear_system::cutoff2resonant */
+constexpr double cutoff2resonant(double w, double damp)
+{
+    return sqrt(-w * w * (1 - 2 * damp * damp) + sqrt(w * w * w * w * (1 - 2 * damp * damp) * (1 - 2 * damp * damp) + w * w * w * w));
+}
+
+template<IntegrationMethod M>
+constexpr FixedCoefficients<1> firstOrderSubstituted(double n1, double n0, double d1, double d0, double ts)
+{
+    // p(s) (gamma z + delta) for p(s) = c0 s + c1
+    typedef Substitution<M> S;
+    return FixedCoefficients<1>{
+        {(n1 * S::alpha(ts) + n0 * S::gamma(ts)) / (d1 * S::alpha(ts) + d0 * S::gamma(ts)),
+         (n1 * S::beta(ts) + n0 * S::delta(ts)) / (d1 * S::alpha(ts) + d0 * S::gamma(ts))},
+        {1,
+         (d1 * S::beta(ts) + d0 * S::delta(ts)) / (d1 * S::alpha(ts) + d0 * S::gamma(ts))},
+        ts};
+}
+
+/*! @brief Coefficient of z^2, z and 1 in p(s) (gamma z + delta)^2, for p(s) = c0 s^2 + c1 s + c2 */
+template<IntegrationMethod M>
+constexpr double z2(double c0, double c1, double c2, double ts)
+{
+    typedef Substitution<M> S;
+    return c0 * S::alpha(ts) * S::alpha(ts) + c1 * S::alpha(ts) * S::gamma(ts) + c2 * S::gamma(ts) * S::gamma(ts);
+}
+
+template<IntegrationMethod M>
+constexpr double z1(double c0, double c1, double c2, double ts)
+{
+    typedef Substitution<M> S;
+    return 2 * c0 * S::alpha(ts) * S::beta(ts) + c1 * (S::alpha(ts) * S::delta(ts) + S::beta(ts) * S::gamma(ts))
+        + 2 * c2 * S::gamma(ts) * S::delta(ts);
+}
+
+template<IntegrationMethod M>
+constexpr double z0(double c0, double c1, double c2, double ts)
+{
+    typedef Substitution<M> S;
+    return c0 * S::beta(ts) * S::beta(ts) + c1 * S::beta(ts) * S::delta(ts) + c2 * S::delta(ts) * S::delta(ts);
+}
+
+constexpr FixedCoefficients<2> monic(double n2, double n1, double n0, double d2, double d1, double d0, double ts)
+{
+    return FixedCoefficients<2>{{n2 / d2, n1 / d2, n0 / d2}, {1, d1 / d2, d0 / d2}, ts};
+}
+
+}
+
+/**
+ * @brief Discretizes (n1 s + n0) / (d1 s + d0).
+ */
+template<IntegrationMethod M>
+constexpr FixedCoefficients<1> transferFunction(double n1, double n0, double d1, double d0, double ts)
+{
+    return detail::firstOrderSubstituted<M>(n1, n0, d1, d0, ts);
+}
+
+/**
+ * @brief Discretizes (n2 s^2 + n1 s + n0) / (d2 s^2 + d1 s + d0).
+ */
+template<IntegrationMethod M>
+constexpr FixedCoefficients<2> transferFunction(double n2, double n1, double n0, double d2, double d1, double d0,
+    double ts)
+{
+    return detail::monic(detail::z2<M>(n2, n1, n0, ts), detail::z1<M>(n2, n1, n0, ts), detail::z0<M>(n2, n1, n0, ts),
+                         detail::z2<M>(d2, d1, d0, ts), detail::z1<M>(d2, d1, d0, ts), detail::z0<M>(d2, d1, d0, ts), ts);
+}
+
+/**
+ * @brief Same filter as Builder::createSecondOrder.
+ */
+template<IntegrationMethod M>
+constexpr FixedCoefficients<2> secondOrder(double damp, double cutoff, double ts)
+{
+    return transferFunction<M>(0, detail::cutoff2resonant(cutoff, damp) * detail::cutoff2resonant(cutoff, damp), 0,
+                               1, 2 * damp * detail::cutoff2resonant(cutoff, damp),
+                               detail::cutoff2resonant(cutoff, damp) * detail::cutoff2resonant(cutoff, damp), ts);
+}
+
+/**
+ * @brief Same filter as Builder::createReferenceFilter2I(kp, ki, kd).
+ */
+template<IntegrationMethod M>
+constexpr FixedCoefficients<2> referenceFilter2I(double kp, double ki, double kd, double ts)
+{
+    return transferFunction<M>(0, 0, ki, kd, kp, ki, ts);
+}
+
+/**
+ * @brief Same filter as Builder::createReferenceFilter2I(kp, kd).
+ */
+template<IntegrationMethod M>
+constexpr FixedCoefficients<1> referenceFilter2I(double kp, double kd, double ts)
+{
+    return transferFunction<M>(0, kp, kd, kp, ts);
+}
+
+/**
+ * @brief Same filter as Builder::createReferenceFilterI.
+ */
+template<IntegrationMethod M>
+constexpr FixedCoefficients<1> referenceFilterI(double kp, double ki, double ts)
+{
+    return transferFunction<M>(0, ki, kp, ki, ts);
+}
+
+}
+
+/*!
+ * \brief The FixedFilter class runs a single N-th order filter whose size is known at compile
+ * time, without any dynamic memory.
+ *
+ * It uses the transposed direct form II, so each update is 2N+1 multiply-adds which the
+ * compiler fully unrolls. The states are therefore not the ones of #LinearSystem, but the
+ * outputs are.
+ */
+template<unsigned int N>
+class FixedFilter
+{
+    static_assert(N > 0, "FixedFilter needs at least one state");
+
+private:
+    FixedCoefficients<N> coefficients;
+    double state[N];
+
+public:
+    /**
+     * @brief Constructs a filter at rest.
+     */
+    constexpr explicit FixedFilter(const FixedCoefficients<N> &coefficients) :
+        coefficients(coefficients), state()
+    {
+    }
+
+    /**
+     * @brief Advances the filter by one sample period.
+     * @return The output, computed before the state advances.
+     */
+    inline double update(double input)
+    {
+        const double y = coefficients.num[0] * input + state[0];
+        for (unsigned int i = 1; i < N; ++i)
+            state[i - 1] = state[i] + coefficients.num[i] * input - coefficients.den[i] * y;
+        state[N - 1] = coefficients.num[N] * input - coefficients.den[N] * y;
+        return y;
+    }
+
+    /** @brief Zeroes the state. */
+    inline void reset()
+    {
+        for (unsigned int i = 0; i < N; ++i)
+            state[i] = 0;
+    }
+
+    inline constexpr const FixedCoefficients<N> & getCoefficients() const {return coefficients;}
+    inline constexpr double getSampling() const {return coefficients.ts;}
+};
+
+/**
+ * @brief Returns the (shared) #DiscreteRealization of fixed coefficients, to run them on a
+ * #LinearSystem or use them with the rest of the library.
+ */
+template<unsigned int N>
+std::shared_ptr<const DiscreteRealization> realize(const FixedCoefficients<N> &coefficients)
+{
+    Poly num(N + 1), den(N + 1);
+    for (unsigned int i = 0; i <= N; ++i)
+    {
+        num(i) = coefficients.num[i];
+        den(i) = coefficients.den[i];
+    }
+    return DesignCache::instance().get(num, den, coefficients.ts, DIRECT, 0);
+}
+
+}
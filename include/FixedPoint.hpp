@@ -0,0 +1,121 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace linear_system
+{
+
+/*!
+ * \brief The FixedPointRealization class holds an integer-only version of a discrete realization.
+ *
+ * It is derived from the (A,B,C,D) realization of a #DiscreteRealization:
+ *  - the states are rescaled by powers of two so that, for inputs within the given range,
+ *    each of them is bounded by that range (the bounds are the L1 norms of the impulse
+ *    responses from the input to each state);
+ *  - inputs and states share one Q format, and the output gets its own from the L1 norm
+ *    of the filter impulse response, both with one guard bit;
+ *  - each row of [A B; C D] gets the Q format that best fits its largest coefficient.
+ *
+ * Every update is then a few int32 by int32 products accumulated in int64, followed by a
+ * rounding shift and saturation to int32, so results are bit-exact on every platform.
+ * Only stable filters can be bounded this way.
+ */
+class FixedPointRealization
+{
+private:
+    unsigned int order;
+
+    /*! @brief Row-major (order+1 by order+1) coefficients of [A B; C D], row r in Q(shifts[r]) */
+    std::vector<int32_t> coefficients;
+
+    /*! @brief Right shift bringing the accumulator of each row back to the format of its result */
+    std::vector<unsigned int> shifts;
+
+    /*! @brief Fractional bits of the inputs and states */
+    int signal_bits;
+
+    /*! @brief Fractional bits of the outputs */
+    int output_bits;
+
+    double Ts;
+
+public:
+    /**
+     * @brief Builds the fixed-point version of \p realization.
+     * @param realization The filter.
+     * @param input_range Largest magnitude the inputs may take; larger inputs saturate.
+     */
+    FixedPointRealization(const DiscreteRealization &realization, double input_range);
+
+    /**
+     * @brief Computes the output of the filter whose state is \p state and advances it.
+     * @param state The #getOrder states, updated in place.
+     * @param scratch Room for #getOrder values.
+     * @param input The input, in the input format.
+     * @return The output, in the output format.
+     */
+    int32_t update(int32_t *state, int32_t *scratch, int32_t input) const;
+
+    /** @brief Converts an input to fixed point, saturating it. */
+    int32_t quantizeInput(double input) const;
+
+    /** @brief Converts a fixed-point output back to floating point. */
+    double outputToDouble(int32_t output) const;
+
+    inline unsigned int getOrder() const {return order;}
+    inline double getSampling() const {return Ts;}
+
+    /** @brief Number of fractional bits of the inputs and states. */
+    inline int getSignalFractionalBits() const {return signal_bits;}
+
+    /** @brief Number of fractional bits of the outputs. */
+    inline int getOutputFractionalBits() const {return output_bits;}
+};
+
+/*!
+ * \brief The FixedPointFilter class runs a #FixedPointRealization, one sample at a time.
+ */
+class FixedPointFilter
+{
+private:
+    std::shared_ptr<const FixedPointRealization> realization;
+    std::vector<int32_t> state;
+    std::vector<int32_t> scratch;
+
+public:
+    /**
+     * @brief Constructs a filter at rest.
+     */
+    explicit FixedPointFilter(std::shared_ptr<const FixedPointRealization> realization);
+
+    /**
+     * @brief Advances the filter by one sample period, with integer arithmetic only.
+     * @param input The input, in the format of #FixedPointRealization::quantizeInput.
+     * @return The output, in the format of #FixedPointRealization::outputToDouble.
+     */
+    inline int32_t update(int32_t input)
+    {
+        return realization->update(state.data(), scratch.data(), input);
+    }
+
+    /**
+     * @brief Same as above, converting from and to floating point.
+     */
+    inline double update(double input)
+    {
+        return realization->outputToDouble(update(realization->quantizeInput(input)));
+    }
+
+    /** @brief Zeroes the state. */
+    void reset();
+
+    /** @brief Returns the (scaled) fixed-point states. */
+    inline const std::vector<int32_t> & getState() const {return state;}
+
+    inline const std::shared_ptr<const FixedPointRealization> & getRealization() const {return realization;}
+};
+
+}
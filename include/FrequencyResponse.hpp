@@ -0,0 +1,47 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include <Eigen/Eigen>
+#include <memory>
+#include <vector>
+
+namespace linear_system
+{
+
+/**
+ * @brief Evaluates the continuous-time frequency response H(jw) of \p realization.
+ * @param realization The filter, whose continuous-time coefficients are used.
+ * @param omega Frequencies (in rad/s).
+ * @param n_threads Number of threads to split the grid across, 0 to use every hardware thread.
+ * @return H(jw) for each entry of \p omega.
+ */
+Eigen::VectorXcd continuousResponse(const DiscreteRealization &realization, const Eigen::VectorXd &omega,
+    unsigned int n_threads = 1);
+
+/**
+ * @brief Evaluates the discrete-time frequency response H(e^{jwTs}) of \p realization.
+ * @param realization The filter, whose discrete-time coefficients are used.
+ * @param omega Frequencies (in rad/s).
+ * @param n_threads Number of threads to split the grid across, 0 to use every hardware thread.
+ * @return H(e^{jwTs}) for each entry of \p omega.
+ */
+Eigen::VectorXcd discreteResponse(const DiscreteRealization &realization, const Eigen::VectorXd &omega,
+    unsigned int n_threads = 1);
+
+/**
+ * @brief Evaluates the continuous-time frequency response of several filters at once.
+ * @return A (omega.size() by realizations.size()) matrix whose i-th column holds the
+ * response of the i-th filter.
+ */
+Eigen::MatrixXcd continuousResponse(const std::vector<std::shared_ptr<const DiscreteRealization> > &realizations,
+    const Eigen::VectorXd &omega, unsigned int n_threads = 1);
+
+/**
+ * @brief Evaluates the discrete-time frequency response of several filters at once.
+ * @return A (omega.size() by realizations.size()) matrix whose i-th column holds the
+ * response of the i-th filter.
+ */
+Eigen::MatrixXcd discreteResponse(const std::vector<std::shared_ptr<const DiscreteRealization> > &realizations,
+    const Eigen::VectorXd &omega, unsigned int n_threads = 1);
+
+}
@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <eigen3/Eigen/Eigen>
+#include "Polynomial.hpp"
 
 namespace linear_system
 {
@@ -44,9 +45,10 @@ Eigen::VectorXd VectorShiftLeft(const Eigen::MatrixBase<Derived> & V, int n)
 }
 
 /*!
- * \brief PolynomialDivision Performs a polynomial division such that N/D = q/D + r
+ * \brief PolynomialDivision Performs a polynomial division such that N/D = q + r/D
  *
  * Note that q and r should have the same size as D prior to calling this function.
+ * See #polynomial::divide for the in-place version.
  *
  * \param N Numerator
  * \param D Denominator
@@ -63,30 +65,36 @@ void PolynomialDivision(const Eigen::MatrixBase<Derived> & N, const Eigen::Matri
     q.resize(s);
     r.resize(s);
 
-    q.setZero();
-    r.setZero();
-    unsigned int i = 0;
+    r = N;
+    polynomial::divide(r, D, q);
+}
 
-    Eigen::VectorXd N_aux(s);
-    N_aux = N;
-    Eigen::VectorXd D_aux(s);
-    int degD = PolynomialDegree(D);
-    int degN_aux = PolynomialDegree(N_aux);
-    int n = degN_aux - degD;
-    double a;
+/*!
+ * \brief Computes the matrix exponential e^M by scaling and squaring with a
+ * degree 13 Pade approximant (Higham, 2005).
+ *
+ * \param M square matrix
+ * \return e^M
+ */
+Eigen::MatrixXd MatrixExponential(const Eigen::MatrixXd &M);
 
-    while (n >= 0)
-    {
-        D_aux = VectorShiftLeft(D,n);
-        a = N_aux(i)/D_aux(i);
-        q(s-n-1) = a;
-        D_aux *= a;
-        N_aux -= D_aux;
-        i ++;
-        n = PolynomialDegree(N_aux) - degD;
-    }
-    r = N_aux;
-}
+/*!
+ * \brief Computes the characteristic polynomial det(zI - M) of a square matrix from its
+ * eigenvalues.
+ *
+ * \param M square matrix
+ * \return The monic coefficients, highest power first
+ */
+Eigen::VectorXd CharacteristicPolynomial(const Eigen::MatrixXd &M);
+
+/*!
+ * \brief Computes the roots of a polynomial as the eigenvalues of its companion matrix,
+ * after scaling the variable so that the roots have magnitudes around 1.
+ *
+ * \param poly coefficients, highest power first; the first one must be nonzero
+ * \return The poly.size() - 1 roots; complex conjugate pairs are adjacent
+ */
+Eigen::VectorXcd PolynomialRoots(const Eigen::VectorXd &poly);
 
 /*!
  * \brief Wraps the angle to the (-pi,pi] interval
@@ -94,7 +102,19 @@ void PolynomialDivision(const Eigen::MatrixBase<Derived> & N, const Eigen::Matri
  * \param ang angle to be wrapped
  */
 void wrap2pi(double &ang);
+
+/*!
+ * \brief Wraps every angle to the (-pi,pi] interval.
+ *
+ * Unlike the scalar version, which calls std::fmod, the bulk versions subtract the nearest
+ * multiple of 2 pi with a branchless vectorized kernel. They agree with it to a few ulps of
+ * the angle for angles up to 1e8 radians, an angle on the edge of the interval possibly
+ * wrapping to the other end.
+ *
+ * \param ang angles to be wrapped, in place
+ */
 void wrap2pi(Eigen::VectorXd &ang);
+void wrap2pi(Eigen::Ref<Eigen::MatrixXd> ang);
 
 /**
  * @brief Computes the cutoff frequency of a nominal second-order system
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include "LinearSystem.hpp"
+#include <memory>
+
+namespace linear_system
+{
+
+/*
+ * Interconnections of filters, compiled to a single realization.
+ *
+ * Each function returns the #STATE_SPACE realization of the interconnection, whose state stacks
+ * the states of the operands, first operand first. A chain of K filters then runs as one
+ * filter, with one state update per sample instead of K. The operands must share their sampling
+ * period; the result is #DIRECT, with no continuous-time model.
+ *
+ * Interconnections may carry states that the input can't reach or that the output doesn't see,
+ * e.g. H + H has twice the order of H; see #minimalRealization.
+ */
+
+/**
+ * @brief Cascade of \p first followed by \p second: the output of \p first is the input of \p second.
+ */
+std::shared_ptr<const DiscreteRealization> series(const std::shared_ptr<const DiscreteRealization> &first,
+    const std::shared_ptr<const DiscreteRealization> &second);
+
+/**
+ * @brief Sum of the outputs of \p first and \p second, both driven by the same input; with
+ * \p sign = -1, their difference.
+ */
+std::shared_ptr<const DiscreteRealization> parallel(const std::shared_ptr<const DiscreteRealization> &first,
+    const std::shared_ptr<const DiscreteRealization> &second, double sign = 1);
+
+/**
+ * @brief Closes a loop around \p forward, whose output goes through \p backward and is added,
+ * multiplied by \p sign, to the input: \p sign = -1 gives the negative feedback forward / (1 + forward backward).
+ *
+ * Throws std::logic_error if the loop is algebraic and singular, i.e. 1 - sign D_f D_b = 0.
+ */
+std::shared_ptr<const DiscreteRealization> feedback(const std::shared_ptr<const DiscreteRealization> &forward,
+    const std::shared_ptr<const DiscreteRealization> &backward, double sign = -1);
+
+/**
+ * @brief Removes the states that the input can't reach, then those that the output doesn't see,
+ * keeping the transfer function.
+ *
+ * The reachable and observable subspaces are spanned by orthonormal Krylov bases (the staircase
+ * algorithm), which is well conditioned for any order.
+ * @param tolerance Directions whose norm falls below \p tolerance times the norm of A are
+ * dropped.
+ * @return A #STATE_SPACE realization in the coordinates of those bases.
+ */
+std::shared_ptr<const DiscreteRealization> minimalRealization(const std::shared_ptr<const DiscreteRealization> &realization,
+    double tolerance = 1e-10);
+
+/*
+ * The same interconnections between filters, which give a new filter running the fused
+ * realization; the states of the operands are not carried over.
+ */
+LinearSystem series(const LinearSystem &first, const LinearSystem &second);
+LinearSystem parallel(const LinearSystem &first, const LinearSystem &second, double sign = 1);
+LinearSystem feedback(const LinearSystem &forward, const LinearSystem &backward, double sign = -1);
+LinearSystem minimalRealization(const LinearSystem &system, double tolerance = 1e-10);
+
+/** @brief The cascade of \p first followed by \p second, as with transfer functions: H2 H1 = series(H1, H2). */
+LinearSystem operator*(const LinearSystem &second, const LinearSystem &first);
+
+/** @brief The parallel connection of \p first and \p second. */
+LinearSystem operator+(const LinearSystem &first, const LinearSystem &second);
+
+/** @brief The difference of the outputs of \p first and \p second. */
+LinearSystem operator-(const LinearSystem &first, const LinearSystem &second);
+
+}
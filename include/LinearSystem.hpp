@@ -1,24 +1,17 @@
 #pragma once
 
+#include "DiscreteRealization.hpp"
+#include "FilterArena.hpp"
+#include "FilterState.hpp"
+#include "PerfEvents.hpp"
 #include <Eigen/Eigen>
+#include <memory>
 #include <stdint.h>
 #include <stdexcept>
 
 namespace linear_system
 {
 
-enum IntegrationMethod
-{
-    FORWARD_EULER,
-    BACKWARD_EULER,
-    TUSTIN
-};
-
-typedef int64_t Time;
-typedef Eigen::VectorXd Poly;
-typedef Eigen::RowVectorXd Input;
-typedef Eigen::VectorXd Output;
-
 /*!
  * \brief The LinearSystem class implements multiple identical N-th order linear filters at once
  */
@@ -28,80 +21,31 @@ public:
     static Time getTimeFromSeconds(double time);
 
 private:
-    //SS realization
-    Eigen::MatrixXd A;
-    Eigen::VectorXd B;
-    Eigen::RowVectorXd C;
-    double D;
-
-    unsigned int order;
-    Eigen::MatrixXd state; //States of the state-space in matrix form (numInputs,stateSize)
+    /*! @brief Discrete transfer function and SS realization, possibly shared with other filters */
+    std::shared_ptr<const DiscreteRealization> realization;
 
-    /*! @brief Filter numerator tfNum[0] s^N + tfNum[1] s^(N-1) + ... + tfNum[N] */
-    Poly tf_num;
+    /*! @brief States, last output and current time of the filters */
+    FilterState fstate;
 
-    /*! @brief Filter denominator tfDen[0] s^N + tfDen[1] s^(N-1) + ... + tfDen[N] */
-    Poly tf_den;
+    /*!
+     * @brief Copy of the last output of #fstate returned by #getOutput, refreshed whenever it
+     * changes, so that a copy of it never aliases the storage of the filter
+     */
+    Output last_output;
 
-    /*! @brief Sampling period (in seconds) */
-    double Ts;
+    unsigned int order;
 
     /*! @brief Amount of filters */
     unsigned int n_filters;
 
-    /*! @brief Filter current time */
-    Time time_current;
-
     /*! @brief Indicates whether or not the initial time has been set */
     bool time_init_set;
 
-    /*! @brief Last output value */
-    Output last_output;
-
-    /*!
-     * \brief Initial output and its N-1 derivatives for each filter
-     *
-     * Each row contains the j-th filter output and its N-1 derivatives at time t = 0
-     */
-    Eigen::MatrixXd initial_output_derivatives;
-
     /*! @brief Maximum amount time between successive calls to Update */
     Time max_delta;
 
-    /*! @brief Integration method */
-    IntegrationMethod integration_method;
-
-    /*!
-     * @brief Prewarp frequency
-     *
-     * Frequency (in rad/s) for which the magnitude response does not change when going
-     * from continuous to discrete-time. This is only considered when using Tustin
-     * integration method.
-     */
-    double prewarp_frequency;
-
-    /*!
-     * \brief Transforms the filter to discrete time.
-     */
-    void discretize();
-
-    /**
-     * @brief Converts the polynomial \p poly from continuous-time do discrete-time using
-     * the forward Euler approximation
-     */
-    void convertFwdEuler(Poly & poly) const;
-
-    /**
-     * @brief Converts the polynomial \p poly from continuous-time do discrete-time using
-     * the backward Euler approximation
-     */
-    void convertBwdEuler(Poly & poly) const;
-
-    /**
-     * @brief Converts the polynomial \p poly from continuous-time do discrete-time using
-     * the Tustin approximation
-     */
-    void convertTustin(Poly & poly) const;
+    /*! @brief Collects the counters of the updates, see #setProfile */
+    std::shared_ptr<PerfProfile> profile;
 
     /*!
      * \brief update Updates all filters (one sample period) based on the given inputs
@@ -110,72 +54,11 @@ private:
     void update(const Input &signalIn);
 
     /*!
-     * \brief Computes the state-space realization (A,B,C,D)
-     */
-    void tf2ss();
-
-    /*!
-     * \brief setFilter Configures the numerator and denominator used by the filters
-     * \param coef_num Numerator coefficients coef_num[0] s^N + coef_num[1] s^(N-1) + ... + coef_num[N]
-     * \param coef_den Denominator coefficients coef_den[0] s^N + coef_den[1] s^(N-1) + ... + coef_den[N]
-     * \param
-     */
-    void setFilter(const Poly &coef_num, const Poly &coef_den);
-
-    /*!
-     * \brief setInitialState Sets the initial state x[0] of the N-th order filter
-     *
-     * The initial state is computed from:
-     *     u[0], ..., u[-(N-1)], the current and N-1 past input samples
-     *     y[0], dy/dt[0], ..., d^(N-1)y/dt^(N-1)[0], the current output and its N-1 derivatives
-     *
-     * The output and its derivatives must be set via #setInitialOutputDerivatives
-     *
-     * \param u_history each i-th row holds u_i[0], ..., u_i[-(N-1)], in this order; that is, the
-     * current input and last N-1 inputs of the i-th input channel
-     * \see #setInitialOutputDerivatives
-     */
-    void setInitialState(const Eigen::MatrixXd & u_history);
-
-    /*!
-     * \brief setInitialOutputDerivatives Sets the initial output and its N-1 derivatives,
-     * where N is the filter order, for each channel
-     *
-     * \param initial_output_derivatives Every row contains y[0], dy/dt[0], ...,
-     * d^(N-1)y/dt^(N-1)[0], in this order and each row corresponds to one independent
-     * instance of the filter defined by this class
-     *
-     * \see #setInitialState
+     * \brief Advances all filters until they reach \p time, leaving the result in #fstate and
+     * #last_output.
+     * \return false if the initial time has not been set, true otherwise.
      */
-    void setInitialOutputDerivatives(const Eigen::MatrixXd & initial_output_derivatives);
-
-    /*!
-     * \brief Configures the prewarp frequency used with Tustin's integration method.
-     *
-     * This method must be called before setFilter.
-     *
-     * \param frequency The prewarp frequency
-     */
-    inline void setPrewarpFrequency(double frequency)
-    {
-        if (integration_method != TUSTIN)
-            frequency = 0;
-        if (frequency >= 0)
-            prewarp_frequency = frequency;
-        else
-            throw std::invalid_argument("LinearSystem::setPrewarpFrequency - frequency must be nonnegative");
-    }
-
-    /*!
-     * \brief Sets the sampling period (in seconds).
-     *
-     * A call to this method silently changes the maximum allowed time between updates
-     * if the new sampling period >= #getMaximumTimeBetweenUpdates. When this happens,
-     * this methods makes a call to #setMaximumTimeBetweenUpdates(10 * sampling_period).
-     *
-     * \param sampling_period positive sampling period.
-     */
-    void setSampling(double sampling_period);
+    bool advance(const Input &signalIn, Time time);
 
 public:
     /**
@@ -186,22 +69,46 @@ public:
      * @param method Integration method.
      * @param prewarp Prewarp frequency to use with Tustin's integration method. Use 0 to
      * disable it. Defaults to 0.
+     * @param form State coordinates of the realization, which also define the states returned
+     * by #getState.
      */
-    LinearSystem(Poly num = Poly::Zero(1), Poly den = Poly::Constant(1,1), double ts = 0.001,
-        IntegrationMethod method = TUSTIN, double prewarp = 0);
+    LinearSystem(const Poly &num = Poly::Zero(1), const Poly &den = Poly::Constant(1,1), double ts = 0.001,
+        IntegrationMethod method = TUSTIN, double prewarp = 0, RealizationForm form = CONTROLLABLE_CANONICAL);
+
+    /**
+     * @brief Constructs a filter that runs an existing realization.
+     * @param realization The discrete realization, which may be shared with other filters.
+     */
+    explicit LinearSystem(std::shared_ptr<const DiscreteRealization> realization);
+
+    /**
+     * @brief Constructs a filter whose states are stored in \p arena.
+     *
+     * Filters built on the same arena keep their states next to each other in memory. The
+     * arena must outlive the filter; copies of the filter store their states on the heap. Only
+     * the copy of the last output behind #getOutput lives on the heap.
+     * @param realization The discrete realization, which may be shared with other filters.
+     * @param arena The arena providing storage for the filter states.
+     */
+    LinearSystem(std::shared_ptr<const DiscreteRealization> realization, FilterArena &arena);
 
     /*!
      * \brief Returns the integration method chosen when calling setFilter;
      * defaults to #IntegrationMethod::Tustin
      * \return The integration method
      */
-    inline IntegrationMethod getIntegrationMethod() const {return integration_method;}
+    inline IntegrationMethod getIntegrationMethod() const {return realization->getIntegrationMethod();}
 
     /*!
      * \brief Returns the prewarp frequency used with Tustin's integration method.
      * \return The prewarp frequency.
      */
-    inline double getPrewarpFrequency() const {return prewarp_frequency;}
+    inline double getPrewarpFrequency() const {return realization->getPrewarpFrequency();}
+
+    /*!
+     * \brief Returns the state coordinates of the realization.
+     */
+    inline RealizationForm getRealizationForm() const {return realization->getRealizationForm();}
 
     /*!
      * \brief getOrder Returns the filter order
@@ -209,7 +116,7 @@ public:
      */
     inline unsigned int getOrder() const
     {
-        return tf_den.size() - 1;
+        return order;
     }
 
     /*!
@@ -219,10 +126,15 @@ public:
      */
     inline void getCoefficients(Eigen::VectorXd & coef_num, Eigen::VectorXd & coef_den) const
     {
-        coef_num = tf_num;
-        coef_den = tf_den;
+        coef_num = realization->getNumerator();
+        coef_den = realization->getDenominator();
     }
 
+    /**
+     * @brief Returns the discrete realization used by this filter.
+     */
+    inline const std::shared_ptr<const DiscreteRealization> & getRealization() const {return realization;}
+
     /*!
      * \brief Chooses how many filters should run in parallel.
      *
@@ -250,19 +162,19 @@ public:
      * \param time The initial time.
      * \see setInitialConditions
      */
-    inline void setInitialTime(Time time) {time_current = time; time_init_set = true;}
+    inline void setInitialTime(Time time) {fstate.time = time; time_init_set = true;}
 
     /**
      * @brief Returns the sampling period in seconds.
      * @return The sampling period.
      */
-    inline double getSampling() const {return Ts;}
+    inline double getSampling() const {return realization->getSampling();}
 
     /**
      * @brief Returns the sampling period in microseconds.
      * @return The sampling period.
      */
-    inline Time getSamplingMicro() const {return Ts * 1000000L;}
+    inline Time getSamplingMicro() const {return realization->getSampling() * 1000000L;}
 
     /*!
      * \brief Returns the maximum time (in seconds) between calls to #update.
@@ -295,19 +207,61 @@ public:
      */
     Output update(const Input &signalIn, Time time);
 
+    /*!
+     * \brief Same as #update, but writes the outputs into \p output instead of returning
+     * a new vector; no memory is allocated in steady state.
+     * \param signalIn input signals.
+     * \param time current time (in microseconds).
+     * \param output receives the output of every filter; it must have #getNFilters entries.
+     */
+    void update(const Input &signalIn, Time time, Eigen::Ref<Output> output);
+
     /**
      * @brief Forces a state for each filter.
      * @param state A (#getNFilters by #getOrder) matrix where each row holds
      * the state of the i-th filter.
      */
-    void setState(const Eigen::MatrixXd &state){this->state = state;}
+    void setState(const Eigen::MatrixXd &state);
 
     /**
      * @brief Returns the states of each one of the #getNFilters filters
      * @return A (#getNFilters by #getOrder) matrix where each row holds
      * the state of the i-th filter.
      */
-    inline Eigen::MatrixXd getState() const {return state;}
+    inline Eigen::MatrixXd getState() const {return fstate.state;}
+
+    /**
+     * @brief Copies the states of each one of the #getNFilters filters into \p state
+     * @param state A (#getNFilters by #getOrder) matrix that receives the states.
+     */
+    void getState(Eigen::Ref<Eigen::MatrixXd> state) const;
+
+    /**
+     * @brief Returns the states, last output and current time of the filters.
+     */
+    inline const FilterState & getFilterState() const {return fstate;}
+
+    /**
+     * @brief Replaces the states, last output and current time of the filters.
+     *
+     * The initial time is considered set after this call.
+     * @param state A state whose dimensions match #getNFilters and #getOrder.
+     */
+    void setFilterState(const FilterState &state);
+
+    /**
+     * @brief Replaces the states, last output and current time of the filters, taking over
+     * the storage of \p state.
+     */
+    void setFilterState(FilterState &&state);
+
+    /**
+     * @brief Attaches a profile collecting the hardware counters of #update and of the initial
+     * state computations, which may be shared with other filters. Only collects when the
+     * library is compiled with LINEAR_SYSTEM_PERF_EVENTS.
+     */
+    inline void setProfile(std::shared_ptr<PerfProfile> profile) {this->profile = std::move(profile);}
+    inline const std::shared_ptr<PerfProfile> & getProfile() const {return profile;}
 };
 
 }
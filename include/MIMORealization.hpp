@@ -0,0 +1,134 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include <Eigen/Eigen>
+#include <memory>
+
+namespace linear_system
+{
+
+/*!
+ * \brief The MIMORealization class holds the discrete state-space realization (A,B,C,D)
+ * of a multi-input multi-output system.
+ *
+ * Instances are immutable once built and can be shared by any number of #MIMOSystem objects.
+ * The matrices are also kept stacked as [A B; C D], so that one step of the system is a
+ * single matrix-vector product with [x; u].
+ */
+class MIMORealization
+{
+private:
+    Eigen::MatrixXd A;
+    Eigen::MatrixXd B;
+    Eigen::MatrixXd C;
+    Eigen::MatrixXd D;
+
+    /*! @brief [A B; C D] */
+    Eigen::MatrixXd stacked;
+
+    /*! @brief Sampling period (in seconds) */
+    double Ts;
+
+    IntegrationMethod integration_method;
+    double prewarp_frequency;
+
+public:
+    /**
+     * @brief Discretizes the continuous-time system dx/dt = Ax + Bu, y = Cx + Du.
+     *
+     * With the #DIRECT method the matrices are taken as a discrete-time system.
+     * @param A (n by n) state matrix.
+     * @param B (n by m) input matrix.
+     * @param C (p by n) output matrix.
+     * @param D (p by m) feedthrough matrix.
+     * @param ts Sampling period (in seconds).
+     * @param method Integration method.
+     * @param prewarp Prewarp frequency to use with Tustin's integration method, 0 to disable it.
+     */
+    MIMORealization(const Eigen::MatrixXd &A, const Eigen::MatrixXd &B, const Eigen::MatrixXd &C,
+        const Eigen::MatrixXd &D, double ts, IntegrationMethod method = TUSTIN, double prewarp = 0);
+
+    /**
+     * @brief Discretizes the continuous-time system (A,B,C,D) into (Ad,Bd,Cd,Dd).
+     *
+     * This is what the constructor uses, and is shared with #DiscreteRealization for the
+     * methods that work on the state-space realization (ZOH, FOH and impulse invariance).
+     */
+    static void discretize(const Eigen::MatrixXd &A, const Eigen::MatrixXd &B, const Eigen::MatrixXd &C,
+        const Eigen::MatrixXd &D, double ts, IntegrationMethod method, double prewarp,
+        Eigen::MatrixXd &Ad, Eigen::MatrixXd &Bd, Eigen::MatrixXd &Cd, Eigen::MatrixXd &Dd);
+
+    inline const Eigen::MatrixXd & getA() const {return A;}
+    inline const Eigen::MatrixXd & getB() const {return B;}
+    inline const Eigen::MatrixXd & getC() const {return C;}
+    inline const Eigen::MatrixXd & getD() const {return D;}
+
+    /** @brief Returns [A B; C D]. */
+    inline const Eigen::MatrixXd & getStacked() const {return stacked;}
+
+    inline unsigned int getOrder() const {return A.rows();}
+    inline unsigned int getNInputs() const {return B.cols();}
+    inline unsigned int getNOutputs() const {return C.rows();}
+    inline double getSampling() const {return Ts;}
+    inline IntegrationMethod getIntegrationMethod() const {return integration_method;}
+    inline double getPrewarpFrequency() const {return prewarp_frequency;}
+};
+
+/*!
+ * \brief The MIMOSystem class runs a #MIMORealization sample by sample.
+ */
+class MIMOSystem
+{
+private:
+    std::shared_ptr<const MIMORealization> realization;
+
+    /*! @brief [x; u], the state followed by the current input */
+    Eigen::VectorXd state_input;
+
+    /*! @brief [x_next; y], the result of one step */
+    Eigen::VectorXd state_output;
+
+public:
+    /**
+     * @brief Constructs a system at rest.
+     * @param realization The discrete realization, which may be shared with other systems.
+     */
+    explicit MIMOSystem(std::shared_ptr<const MIMORealization> realization);
+
+    /**
+     * @brief Advances the system by one sample period.
+     * @param input The m inputs.
+     * @return The p outputs y = Cx + Du, computed before the state advances.
+     */
+    const Eigen::VectorXd::ConstSegmentReturnType update(const Eigen::Ref<const Eigen::VectorXd> &input);
+
+    /**
+     * @brief Runs the system over a block of inputs.
+     * @param input A (m by K) matrix whose columns are consecutive input samples.
+     * @param output Receives the (p by K) outputs; its storage is reused when the size does
+     * not change.
+     */
+    void process(const Eigen::MatrixXd &input, Eigen::MatrixXd &output);
+
+    /** @brief Returns the last output. */
+    inline Eigen::VectorXd::ConstSegmentReturnType getOutput() const
+    {
+        return state_output.tail(realization->getNOutputs());
+    }
+
+    /** @brief Returns the state. */
+    inline Eigen::VectorXd::ConstSegmentReturnType getState() const
+    {
+        return state_input.head(realization->getOrder());
+    }
+
+    /**
+     * @brief Forces the state.
+     * @param state The n states.
+     */
+    void setState(const Eigen::Ref<const Eigen::VectorXd> &state);
+
+    inline const std::shared_ptr<const MIMORealization> & getRealization() const {return realization;}
+};
+
+}
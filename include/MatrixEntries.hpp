@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Eigen/Eigen>
+#include <vector>
+
+namespace linear_system
+{
+
+/*!
+ * \brief A nonzero entry A(row, col) = value of a state matrix.
+ *
+ * State updates that visit only these entries cost about 2N operations per sample for the
+ * canonical realization, instead of N^2.
+ */
+template<typename Scalar = double>
+struct MatrixEntry
+{
+    unsigned int row, col;
+    Scalar value;
+};
+
+/**
+ * @brief Returns the nonzero entries of \p A, column by column, with their values rounded to
+ * \p Scalar.
+ */
+template<typename Scalar = double>
+std::vector<MatrixEntry<Scalar> > nonzeroEntries(const Eigen::MatrixXd &A)
+{
+    std::vector<MatrixEntry<Scalar> > entries;
+    for (Eigen::Index j = 0; j < A.cols(); ++j)
+    {
+        for (Eigen::Index i = 0; i < A.rows(); ++i)
+        {
+            if (A(i, j) != 0)
+                entries.push_back(MatrixEntry<Scalar>{(unsigned int) i, (unsigned int) j, static_cast<Scalar>(A(i, j))});
+        }
+    }
+    return entries;
+}
+
+/**
+ * @brief next += A x for a single state vector, with A given by its nonzero \p entries.
+ */
+template<typename Scalar, typename VectorX, typename VectorNext>
+void addProduct(const std::vector<MatrixEntry<Scalar> > &entries, const VectorX &x, VectorNext &next)
+{
+    for (const MatrixEntry<Scalar> &e : entries)
+        next(e.row) += e.value * x(e.col);
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include <Eigen/Eigen>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace linear_system
+{
+
+/**
+ * @brief Metrics of the unit step response of a filter, relative to its steady-state value.
+ *
+ * Times are in seconds, measured from the step. Levels that are never reached within the
+ * simulated horizon give an infinite time; metrics that are undefined because the steady-state
+ * value is zero are NaN.
+ */
+struct StepMetrics
+{
+    /*! @brief Time to go from 10% to 90% of the steady-state value */
+    double rise_time;
+
+    /*! @brief Peak excess over the steady-state value, as a fraction of it */
+    double overshoot;
+
+    /*! @brief Time after which the response stays within the settling band */
+    double settling_time;
+
+    /*! @brief Steady-state value, the DC gain of the filter */
+    double final_value;
+};
+
+/**
+ * @brief Simulates the unit step response of \p realization and computes its metrics on the fly,
+ * without storing the trajectory.
+ * @param realization The filter, started at rest.
+ * @param duration Simulated horizon (in seconds).
+ * @param band Half-width of the settling band, relative to the steady-state value (or to the
+ * step when the steady-state value is zero).
+ */
+StepMetrics stepResponseMetrics(const DiscreteRealization &realization, double duration, double band = 0.02);
+
+/*!
+ * \brief Builds a filter from one row of a parameter grid.
+ */
+typedef std::function<std::shared_ptr<const DiscreteRealization>(const Eigen::VectorXd &)> DesignFunction;
+
+/**
+ * @brief Returns every combination of the given parameter values, one per row, with the last
+ * parameter varying fastest.
+ * @param axes The values of each parameter.
+ * @return A (product of the axes sizes by axes.size()) matrix.
+ */
+Eigen::MatrixXd cartesianGrid(const std::vector<Eigen::VectorXd> &axes);
+
+/**
+ * @brief Builds and simulates every candidate of \p grid, splitting them across threads.
+ * @param design Builds the filter of a candidate from its parameters; it is called concurrently.
+ * @param grid One candidate per row.
+ * @param duration Simulated horizon (in seconds).
+ * @param band Settling band, see #stepResponseMetrics.
+ * @param n_threads Number of threads, 0 to use every hardware thread.
+ * @return A (grid.rows() by 3) table whose columns hold the rise time, overshoot and settling
+ * time of each candidate.
+ */
+Eigen::MatrixXd sweepStepResponse(const DesignFunction &design, const Eigen::MatrixXd &grid, double duration,
+    double band = 0.02, unsigned int n_threads = 1);
+
+/**
+ * @brief Sweeps Builder::createSecondOrder over a grid whose columns are (damp, cutoff).
+ * \see sweepStepResponse
+ */
+Eigen::MatrixXd sweepSecondOrder(const Eigen::MatrixXd &grid, double duration, double band = 0.02,
+    unsigned int n_threads = 1);
+
+/**
+ * @brief Sweeps Builder::createReferenceFilter2I over a grid whose columns are (kp, ki, kd).
+ * \see sweepStepResponse
+ */
+Eigen::MatrixXd sweepReferenceFilter2I(const Eigen::MatrixXd &grid, double duration, double band = 0.02,
+    unsigned int n_threads = 1);
+
+}
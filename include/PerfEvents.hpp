@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+
+namespace linear_system
+{
+
+/*! @brief Instrumented sections of the library */
+enum PerfSection
+{
+    PERF_UPDATE,
+    PERF_DISCRETIZE,
+    PERF_TF2SS,
+    PERF_SET_INITIAL_STATE,
+    N_PERF_SECTIONS
+};
+
+/*! @brief Totals of a section over all of its calls */
+struct PerfCounts
+{
+    uint64_t calls;
+    uint64_t nanoseconds;
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t cache_references;
+    uint64_t cache_misses;
+};
+
+/*!
+ * \brief The PerfProfile class aggregates the hardware counters of the instrumented sections.
+ *
+ * The instrumentation is only compiled in with the LINEAR_SYSTEM_PERF_EVENTS CMake option;
+ * without it profiles can still be attached but stay empty, and the sections cost nothing.
+ *
+ * With it, every section entered on behalf of an object with an attached profile (see
+ * #LinearSystem::setProfile and the banks' equivalents) reads the counters of the calling thread
+ * before and after, and adds the difference to the profile. Several objects may share one
+ * profile to aggregate them. Designs are not attached to an object and go to #global.
+ *
+ * Counters come from Linux perf_event_open, counting user space only for the calling thread.
+ * When they cannot be opened (see /proc/sys/kernel/perf_event_paranoid, or a virtual machine
+ * without a PMU) only calls and elapsed time are collected, see #countersAvailable. Each read
+ * is a system call, which is negligible against a design but not against the update of a single
+ * filter: instrument banks, or updates of many filters, to get meaningful per-sample figures.
+ */
+class PerfProfile
+{
+private:
+    struct Section
+    {
+        std::atomic<uint64_t> calls, nanoseconds, cycles, instructions, cache_references, cache_misses;
+    };
+
+    Section sections[N_PERF_SECTIONS];
+
+public:
+    PerfProfile();
+    PerfProfile(const PerfProfile &) = delete;
+    PerfProfile & operator=(const PerfProfile &) = delete;
+
+    /** @brief Whether the library was compiled with the instrumentation. */
+    static bool compiledIn();
+
+    /** @brief Whether the hardware counters can be opened for the calling thread. */
+    static bool countersAvailable();
+
+    /** @brief Profile of the designs (discretize and tf2ss). */
+    static PerfProfile & global();
+
+    static const char * sectionName(PerfSection section);
+
+    void add(PerfSection section, const PerfCounts &counts);
+    PerfCounts get(PerfSection section) const;
+    void reset();
+
+    /**
+     * @brief Writes one line per section that was entered: calls, then time, cycles,
+     * instructions and cache misses per call, instructions per cycle and the cache miss ratio.
+     * @param name Written in the header line, to tell profiles apart.
+     */
+    void report(std::ostream &out, const std::string &name = "") const;
+};
+
+/*!
+ * \brief Adds the counters of its lifetime to a section of a profile; does nothing for a null
+ * profile.
+ */
+class PerfScope
+{
+private:
+    PerfProfile *profile;
+    PerfSection section;
+    PerfCounts start;
+
+public:
+    PerfScope(PerfProfile *profile, PerfSection section);
+    ~PerfScope();
+    PerfScope(const PerfScope &) = delete;
+    PerfScope & operator=(const PerfScope &) = delete;
+};
+
+}
+
+#ifdef LINEAR_SYSTEM_PERF_EVENTS
+#define LINEAR_SYSTEM_PERF_SCOPE(profile, section) ::linear_system::PerfScope perf_scope_(profile, section)
+#else
+#define LINEAR_SYSTEM_PERF_SCOPE(profile, section)
+#endif
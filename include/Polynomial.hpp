@@ -0,0 +1,190 @@
+#pragma once
+
+#include <Eigen/Eigen>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <stdexcept>
+
+namespace linear_system
+{
+
+/*!
+ * \brief Allocation-free polynomial arithmetic.
+ *
+ * Coefficients are stored highest power first, like everywhere else in the library. Every
+ * function takes Eigen expressions and writes into storage given by the caller, so that nothing
+ * is allocated beyond what the caller provides: with fixed-size vectors, such as
+ * Eigen::Matrix<double, 3, 1>, everything stays on the stack, roots included.
+ *
+ * Degrees are detected relative to the largest coefficient, so that scaling a polynomial never
+ * changes its degree.
+ */
+namespace polynomial
+{
+
+/*! @brief Coefficients smaller than this, relative to the largest one, are taken as zeros */
+const double default_tolerance = 64 * std::numeric_limits<double>::epsilon();
+
+/**
+ * @brief Degree of \p p: the power of its first coefficient above \p tolerance times the
+ * largest one, or 0 for the zero polynomial.
+ */
+template<typename Derived>
+int degree(const Eigen::MatrixBase<Derived> &p, double tolerance = default_tolerance)
+{
+    const Eigen::Index n = p.size();
+    if (n == 0)
+        return 0;
+    const double threshold = tolerance * p.cwiseAbs().maxCoeff();
+    for (Eigen::Index i = 0; i < n; ++i)
+    {
+        if (std::abs(p(i)) > threshold)
+            return int(n - 1 - i);
+    }
+    return 0;
+}
+
+/** @brief Value of \p p at \p x, by Horner's scheme; \p x may be complex. */
+template<typename Derived, typename Scalar>
+Scalar evaluate(const Eigen::MatrixBase<Derived> &p, const Scalar &x)
+{
+    Scalar value = 0;
+    for (Eigen::Index i = 0; i < p.size(); ++i)
+        value = value * x + p(i);
+    return value;
+}
+
+/**
+ * @brief Synthetic division num = quotient den + remainder, in place.
+ * @param num The numerator on input, the remainder on output, with the same size; the
+ * coefficients of the powers reached by the quotient are exactly zero.
+ * @param den The denominator; it must not be the zero polynomial.
+ * @param quotient As many coefficients as \p num, so that they line up with it: the constant
+ * term is the last one, and the unused leading ones are zero.
+ */
+template<typename DerivedN, typename DerivedD, typename DerivedQ>
+void divide(Eigen::MatrixBase<DerivedN> &num, const Eigen::MatrixBase<DerivedD> &den,
+            Eigen::MatrixBase<DerivedQ> &quotient, double tolerance = default_tolerance)
+{
+    if (quotient.size() != num.size())
+        throw std::logic_error("the quotient must have as many coefficients as the numerator");
+    if (den.size() == 0 || den.cwiseAbs().maxCoeff() == 0)
+        throw std::logic_error("division by the zero polynomial");
+
+    const Eigen::Index m = degree(den, tolerance);
+    const Eigen::Index lead = den.size() - 1 - m;
+    quotient.setZero();
+    for (Eigen::Index i = 0; i + m < num.size(); ++i)
+    {
+        const double a = num(i) / den(lead);
+        quotient(i + m) = a;
+        num.segment(i, m + 1) -= a * den.segment(lead, m + 1);
+        num(i) = 0;
+    }
+}
+
+/**
+ * @brief Product of \p a and \p b.
+ * @param out a.size() + b.size() - 1 coefficients; it must not overlap the operands.
+ */
+template<typename DerivedA, typename DerivedB, typename DerivedOut>
+void multiply(const Eigen::MatrixBase<DerivedA> &a, const Eigen::MatrixBase<DerivedB> &b,
+              Eigen::MatrixBase<DerivedOut> &out)
+{
+    if (a.size() == 0 || b.size() == 0 || out.size() != a.size() + b.size() - 1)
+        throw std::logic_error("the product must have a.size() + b.size() - 1 coefficients");
+
+    out.setZero();
+    for (Eigen::Index i = 0; i < a.size(); ++i)
+        out.segment(i, b.size()) += a(i) * b;
+}
+
+/**
+ * @brief Substitutes s = (alpha z + beta) / (gamma z + delta) in \p p and clears the
+ * denominators: out(z) = (gamma z + delta)^n p(s), with n = p.size() - 1.
+ *
+ * This is how the forward and backward Euler and Tustin approximations map continuous-time
+ * polynomials to discrete time. The powers of both factors are built by repeated products
+ * with exact integer coefficients, which keeps the binomial coefficients exact at any order.
+ *
+ * @param out As many coefficients as \p p; it must not overlap it.
+ * @param scratch As many coefficients as \p p, overwritten.
+ */
+template<typename DerivedP, typename DerivedOut, typename DerivedScratch>
+void substitute(const Eigen::MatrixBase<DerivedP> &p, double alpha, double beta, double gamma, double delta,
+                Eigen::MatrixBase<DerivedOut> &out, Eigen::MatrixBase<DerivedScratch> &scratch)
+{
+    const Eigen::Index n = p.size() - 1;
+    if (out.size() != p.size() || scratch.size() != p.size())
+        throw std::logic_error("the output and scratch must have as many coefficients as the polynomial");
+    if (n < 0)
+        return;
+
+    // out_k = out_{k-1} (alpha z + beta) + p_k (gamma z + delta)^k, with the k-th power in
+    // scratch; both are right-aligned, so the products by a linear factor run in place
+    out.setZero();
+    scratch.setZero();
+    out(n) = p(0);
+    scratch(n) = 1;
+    for (Eigen::Index k = 1; k <= n; ++k)
+    {
+        for (Eigen::Index i = n - k; i < n; ++i)
+        {
+            out(i) = alpha * out(i + 1) + beta * out(i);
+            scratch(i) = gamma * scratch(i + 1) + delta * scratch(i);
+        }
+        out(n) *= beta;
+        scratch(n) *= delta;
+        out.tail(k + 1) += p(k) * scratch.tail(k + 1);
+    }
+}
+
+/*! @brief Number of roots of a polynomial of type Derived, when known at compile time */
+template<typename Derived>
+struct RootCount
+{
+    static const int value = (Derived::SizeAtCompileTime == Eigen::Dynamic) ?
+        int(Eigen::Dynamic) : int(Derived::SizeAtCompileTime) - 1;
+};
+
+/**
+ * @brief Roots of \p p, as the eigenvalues of its companion matrix after scaling the variable
+ * so that the roots have magnitudes around 1.
+ *
+ * The companion matrix has the size of \p p, so fixed-size polynomials are solved on the stack.
+ *
+ * @param p Coefficients, highest power first; the first one must be nonzero.
+ * @return The p.size() - 1 roots; complex conjugate pairs are adjacent.
+ */
+template<typename Derived>
+Eigen::Matrix<std::complex<double>, RootCount<Derived>::value, 1> roots(const Eigen::MatrixBase<Derived> &p)
+{
+    typedef Eigen::Matrix<double, RootCount<Derived>::value, RootCount<Derived>::value> Companion;
+    typedef Eigen::Matrix<std::complex<double>, RootCount<Derived>::value, 1> Roots;
+
+    const Eigen::Index n = p.size() - 1;
+    if (n <= 0)
+        return Roots(0);
+    if (p(0) == 0)
+        throw std::logic_error("the leading coefficient of the polynomial can't be zero");
+
+    // Roots of p(w x), with w a bound on the root magnitudes, are much better conditioned
+    double w = 0;
+    for (Eigen::Index k = 1; k <= n; ++k)
+        w = std::max(w, std::pow(std::abs(p(k) / p(0)), 1.0 / k));
+    if (w == 0)
+        w = 1;
+
+    Companion companion = Companion::Zero(n, n);
+    companion.topRightCorner(n-1, n-1).setIdentity();
+    for (Eigen::Index k = 1; k <= n; ++k)
+        companion(n-1, n-k) = -p(k) / p(0) / std::pow(w, k);
+    Eigen::EigenSolver<Companion> solver(companion, false);
+    return w * solver.eigenvalues();
+}
+
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace linear_system
+{
+
+/*!
+ * \brief The ThreadPool class runs submitted tasks on a fixed set of worker threads and
+ * returns their results as futures.
+ *
+ * Tasks are started in submission order. Filters are not thread-safe, so a filter must not
+ * be used by two pending tasks at once; independent filters can be updated concurrently.
+ */
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()> > tasks;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool stopping;
+
+    void enqueue(std::function<void()> task);
+    void work();
+
+public:
+    /**
+     * @brief Starts the workers.
+     * @param n_threads Number of workers, 0 for the number of hardware threads.
+     */
+    explicit ThreadPool(unsigned int n_threads = 0);
+
+    /**
+     * @brief Runs the tasks still queued, then stops the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Queues \p task.
+     * @return The future result of \p task, or the exception it throws.
+     */
+    template<typename Task>
+    std::future<typename std::result_of<Task()>::type> submit(Task task)
+    {
+        typedef typename std::result_of<Task()>::type Result;
+        std::shared_ptr<std::packaged_task<Result()> > packaged =
+            std::make_shared<std::packaged_task<Result()> >(std::move(task));
+        std::future<Result> result = packaged->get_future();
+        enqueue([packaged]() {(*packaged)();});
+        return result;
+    }
+
+    inline unsigned int size() const {return workers.size();}
+};
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Eigen/Eigen>
+
+namespace linear_system
+{
+
+/*!
+ * \brief The Unwrapper class removes the 2 pi jumps of wrapped angle signals, sample by sample.
+ *
+ * Each channel keeps its previous angle and its number of turns: every new angle is shifted by
+ * the multiple of 2 pi that brings it within pi of the previous one, as numpy.unwrap does, so
+ * the unwrapped signal is continuous and can be filtered. The turns are counted as integers
+ * and every output is computed from its input and the count, so rounding errors never
+ * accumulate, however long the stream.
+ *
+ * Channels are laid out like in #FilterBank and #CoefficientBank, so unwrapping can be fused in
+ * front of a bank, sample by sample, while both work on the same vectors:
+ * \code
+ * unwrapper.update(angles, unwrapped);
+ * bank.update(unwrapped, output);
+ * \endcode
+ * The kernels are branchless loops, vectorized across channels.
+ */
+class Unwrapper
+{
+private:
+    /*! @brief Previous input angle of each channel */
+    Eigen::VectorXd previous;
+
+    /*! @brief Number of turns added to each channel */
+    Eigen::VectorXd turns;
+
+    bool started;
+
+public:
+    /** @brief Constructs \p n_channels channels; the first sample of each passes unchanged. */
+    explicit Unwrapper(unsigned int n_channels = 1);
+
+    /** @brief Forgets the history, so that the next sample passes unchanged. */
+    void reset();
+
+    /**
+     * @brief Unwraps one sample of every channel.
+     * @param angles One angle per channel.
+     * @param unwrapped Receives one angle per channel; may be \p angles itself.
+     */
+    void update(const Eigen::Ref<const Eigen::VectorXd> &angles, Eigen::Ref<Eigen::VectorXd> unwrapped);
+
+    /**
+     * @brief Unwraps a block of samples.
+     * @param input A (channels by samples) matrix, one column per sample like #FilterBank::process.
+     * @param output Receives the unwrapped angles, with the same layout.
+     */
+    void process(const Eigen::MatrixXd &input, Eigen::MatrixXd &output);
+
+    inline unsigned int getNChannels() const {return previous.size();}
+
+    /** @brief Returns the number of turns added so far to each channel. */
+    inline const Eigen::VectorXd & getTurns() const {return turns;}
+};
+
+}
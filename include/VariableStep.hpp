@@ -0,0 +1,124 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include <Eigen/Eigen>
+#include <memory>
+#include <unordered_map>
+
+namespace linear_system
+{
+
+/*!
+ * \brief The VariableStepSystem class runs filters on irregularly sampled inputs, advancing
+ * the continuous-time model exactly over the time elapsed between updates.
+ *
+ * #LinearSystem assumes a fixed sampling period: it rounds the elapsed time down to whole
+ * periods and runs one update per period, so a jittery clock moves the samples to the period
+ * grid and late updates cost catch-up work. Here every update is a single step of the
+ * zero-order-hold discretization of the continuous model over the actual elapsed time, each
+ * input being held until the next update.
+ *
+ * The discretizations are cached, keyed on the elapsed time rounded to a multiple of a time
+ * quantum; the rounding error is carried over to the next update, so it never accumulates.
+ * The states are those of the controllable canonical realization of the continuous model,
+ * which is also the one of #ZOH designs: with a regular clock and from rest, the outputs are
+ * those of a #LinearSystem using the #ZOH method.
+ */
+class VariableStepSystem
+{
+private:
+    struct Step
+    {
+        Eigen::MatrixXd Phi;
+        Eigen::VectorXd Gamma;
+    };
+
+    std::shared_ptr<const DiscreteRealization> realization;
+
+    /*! @brief Continuous-time realization */
+    Eigen::MatrixXd Ac;
+    Eigen::VectorXd Bc;
+    Eigen::RowVectorXd Cc;
+    double Dc;
+
+    /*! @brief Discretizations over multiples of #quantum, keyed on the multiple */
+    std::unordered_map<Time, Step> steps;
+
+    /*! @brief Resolution of the cache keys (in microseconds) */
+    Time quantum;
+
+    /*! @brief (n_filters by order) states */
+    Eigen::MatrixXd state;
+
+    /*! @brief Inputs of the last update, held until the next one */
+    Input held_input;
+
+    Output last_output;
+
+    /*! @brief Time the states correspond to, within half a quantum of the last update */
+    Time state_time;
+    bool time_init_set;
+
+    /*! @brief Scratch for the next states */
+    Eigen::MatrixXd next;
+
+    const Step & step(Time multiple);
+
+public:
+    /**
+     * @brief Constructs one filter at rest.
+     * @param realization The filter; it must have a continuous-time model (see
+     * #DiscreteRealization::hasContinuousModel).
+     * @param quantum Resolution (in microseconds) of the elapsed times used as cache keys.
+     */
+    explicit VariableStepSystem(std::shared_ptr<const DiscreteRealization> realization, Time quantum = 1);
+
+    /*!
+     * \brief Chooses how many filters run in parallel, and puts them at rest.
+     */
+    void useNFilters(unsigned int n_filters);
+
+    /*!
+     * \brief Sets the time of the current states.
+     */
+    inline void setInitialTime(Time time) {state_time = time; time_init_set = true;}
+
+    /**
+     * @brief Advances every filter to \p time, then computes its output.
+     *
+     * The states advance over the time elapsed since the last update, with the inputs of the
+     * last update held (zero before the first one). Updates at the same or an earlier time
+     * do not advance the states.
+     * @param signalIn The inputs, one per filter.
+     * @param time The current time (in microseconds).
+     * @return The outputs y = Cx + Du.
+     */
+    Output update(const Input &signalIn, Time time);
+
+    /**
+     * @brief Same as #update, but writes the outputs into \p output.
+     */
+    void update(const Input &signalIn, Time time, Eigen::Ref<Output> output);
+
+    /**
+     * @brief Returns a (#getNFilters by order) matrix where each row holds the state of a filter.
+     */
+    inline const Eigen::MatrixXd & getState() const {return state;}
+
+    /**
+     * @brief Forces the states, with the layout of #getState.
+     */
+    void setState(const Eigen::MatrixXd &state);
+
+    inline const Output & getOutput() const {return last_output;}
+    inline unsigned int getNFilters() const {return state.rows();}
+    inline unsigned int getOrder() const {return state.cols();}
+    inline Time getQuantum() const {return quantum;}
+
+    /** @brief Returns the number of cached discretizations. */
+    inline std::size_t getCacheSize() const {return steps.size();}
+
+    inline const std::shared_ptr<const DiscreteRealization> & getRealization() const {return realization;}
+};
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include <Eigen/Eigen>
+
+namespace linear_system
+{
+
+/**
+ * @brief Zero-phase filtering: runs the filter forward, then backward over its own output.
+ *
+ * The result has the phase of neither pass and the squared magnitude response of the filter.
+ * Edge transients are reduced like SciPy's filtfilt does: the input is extended at both ends
+ * by \p padlen samples reflected about its end points, and each pass starts from the steady
+ * state of its first input sample.
+ *
+ * Channels are processed in blocks like #simulateBatch; the backward pass reads the output of
+ * the forward pass in reverse, in place, so the only extra memory is the padding.
+ * @param realization The filter; it must not have a pole at z = 1, since the steady states
+ * would not exist.
+ * @param input A (channels by N) matrix whose i-th row holds the N samples of the i-th channel.
+ * @param padlen Number of samples of the extensions, smaller than N; -1 selects 3 (order + 1),
+ * the default of SciPy.
+ * @param n_threads Number of threads to split the channels across, 0 to use every hardware thread.
+ * @return A (channels by N) matrix holding the outputs, row by row.
+ */
+Eigen::MatrixXd filtfilt(const DiscreteRealization &realization, const Eigen::MatrixXd &input, int padlen = -1,
+    unsigned int n_threads = 1);
+
+}
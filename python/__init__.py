@@ -1 +1,15 @@
 from .linear_system_py import *
+
+import asyncio
+
+
+async def wait(pending):
+    """Awaits a PendingVector or PendingMatrix without blocking the event loop.
+
+    The result is waited for in the default executor; the wait releases the GIL."""
+    return await asyncio.get_running_loop().run_in_executor(None, pending.result)
+
+
+# Results of ThreadPool tasks can be awaited directly
+PendingVector.__await__ = lambda self: wait(self).__await__()
+PendingMatrix.__await__ = lambda self: wait(self).__await__()
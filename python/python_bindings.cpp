@@ -3,6 +3,22 @@
 #include <pybind11/stl.h>
 
 #include "LinearSystem.hpp"
+#include "Builder.hpp"
+#include "CoefficientBank.hpp"
+#include "Decimator.hpp"
+#include "MIMORealization.hpp"
+#include "DesignCache.hpp"
+#include "FrequencyResponse.hpp"
+#include "BatchSimulation.hpp"
+#include "ParameterSweep.hpp"
+#include "ThreadPool.hpp"
+#include "ZeroPhase.hpp"
+#include "VariableStep.hpp"
+#include "Unwrap.hpp"
+#include "Interconnection.hpp"
+#include "HelperFunctions.hpp"
+
+#include <chrono>
 
 namespace py = pybind11;
 using namespace linear_system;
@@ -14,36 +30,311 @@ Eigen::VectorXd update(LinearSystem &sys, const Eigen::RowVectorXd &input, Time
     return sys.update(input, time);
 }
 
+// Row k of input holds the inputs of every filter at time + k sampling periods
+Eigen::MatrixXd process(LinearSystem &sys, const Eigen::MatrixXd &input, Time time)
+{
+    Eigen::MatrixXd output(input.rows(), input.cols());
+    for (Eigen::Index k = 0; k < input.rows(); ++k)
+        output.row(k) = sys.update(input.row(k), time + k * sys.getSamplingMicro()).transpose();
+    return output;
+}
+
+Eigen::MatrixXd processBank(CoefficientBank &bank, const Eigen::MatrixXd &input)
+{
+    Eigen::MatrixXd output;
+    bank.process(input, output);
+    return output;
+}
+
+// Result of a task of a ThreadPool. The filter used by the task is kept alive by the Python
+// object, so destroying it waits for the task to finish.
+template<typename T>
+struct Pending
+{
+    std::shared_future<T> future;
+
+    explicit Pending(std::future<T> &&future) : future(future.share()) {}
+    Pending(Pending &&) = default;
+    ~Pending()
+    {
+        if (future.valid() && !done())
+        {
+            py::gil_scoped_release release;
+            future.wait();
+        }
+    }
+
+    bool done() const {return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;}
+};
+
+template<typename T>
+void bindPending(py::module &m, const char *name)
+{
+    py::class_<Pending<T> >(m, name)
+        .def("done", &Pending<T>::done)
+        .def("result", [](const Pending<T> &pending) {return pending.future.get();},
+             py::call_guard<py::gil_scoped_release>())
+    ;
+}
+
+std::vector<std::shared_ptr<const DiscreteRealization> > realizations(const std::vector<LinearSystem> &systems)
+{
+    std::vector<std::shared_ptr<const DiscreteRealization> > ret;
+    for (const LinearSystem &sys : systems)
+        ret.push_back(sys.getRealization());
+    return ret;
+}
+
 PYBIND11_MODULE(linear_system_py, m) {
     py::enum_<IntegrationMethod>(m, "IntegrationMethod")
         .value("TUSTIN", TUSTIN)
         .value("FORWARD_EULER", FORWARD_EULER)
         .value("BACKWARD_EULER", BACKWARD_EULER)
+        .value("ZOH", ZOH)
+        .value("FOH", FOH)
+        .value("IMPULSE_INVARIANT", IMPULSE_INVARIANT)
+        .value("DIRECT", DIRECT)
+        .export_values();
+
+    py::enum_<RealizationForm>(m, "RealizationForm")
+        .value("CONTROLLABLE_CANONICAL", CONTROLLABLE_CANONICAL)
+        .value("MODAL", MODAL)
+        .value("BALANCED", BALANCED)
+        .value("STATE_SPACE", STATE_SPACE)
         .export_values();
 
     py::class_<LinearSystem>(m, "LinearSystem")
-        .def(py::init<Eigen::VectorXd, Eigen::VectorXd, double, IntegrationMethod, double>(),
+        .def(py::init<const Eigen::VectorXd &, const Eigen::VectorXd &, double, IntegrationMethod, double, RealizationForm>(),
              py::arg("num") = Eigen::VectorXd::Zero(2),
              py::arg("den") = Eigen::VectorXd::Constant(2,1),
              py::arg("ts") = 0.001,
              py::arg("integration_method") = TUSTIN,
-             py::arg("prewarp") = 0)
+             py::arg("prewarp") = 0,
+             py::arg("form") = CONTROLLABLE_CANONICAL)
         .def_static("getTimeFromSeconds", &LinearSystem::getTimeFromSeconds)
         .def("getIntegrationMethod", &LinearSystem::getIntegrationMethod)
         .def("getPrewarpFrequency", &LinearSystem::getPrewarpFrequency)
+        .def("getRealizationForm", &LinearSystem::getRealizationForm)
         .def("getOrder", &LinearSystem::getOrder)
         .def("getCoefficients", &LinearSystem::getCoefficients)
         .def("useNFilters", &LinearSystem::useNFilters)
         .def("getSampling", &LinearSystem::getSampling)
         .def("getMaximumTimeBetweenUpdates", &LinearSystem::getMaximumTimeBetweenUpdates)
         .def("getNFilters", &LinearSystem::getNFilters)
-        .def("getState", &LinearSystem::getState)
-        .def("getOutput", &LinearSystem::getOutput)
+        .def("getState", static_cast<Eigen::MatrixXd (LinearSystem::*)() const>(&LinearSystem::getState))
+        .def("getOutput", [](const LinearSystem &sys) {return Output(sys.getOutput());})
         .def("setMaximumTimeBetweenUpdates", &LinearSystem::setMaximumTimeBetweenUpdates)
         .def("setInitialTime", &LinearSystem::setInitialTime)
-        .def("update", &update)
+        .def("update", &update, py::call_guard<py::gil_scoped_release>())
+        .def("process", &process, py::arg("input"), py::arg("time"), py::call_guard<py::gil_scoped_release>())
         .def("setInitialConditions", &LinearSystem::setInitialConditions)
-        .def("setState", &LinearSystem::setState)
+        .def("continuousResponse", [](const LinearSystem &sys, const Eigen::VectorXd &omega, unsigned int n_threads) {
+                return continuousResponse(*sys.getRealization(), omega, n_threads);
+             }, py::arg("omega"), py::arg("n_threads") = 1, py::call_guard<py::gil_scoped_release>())
+        .def("discreteResponse", [](const LinearSystem &sys, const Eigen::VectorXd &omega, unsigned int n_threads) {
+                return discreteResponse(*sys.getRealization(), omega, n_threads);
+             }, py::arg("omega"), py::arg("n_threads") = 1, py::call_guard<py::gil_scoped_release>())
+        .def("simulateBatch", [](const LinearSystem &sys, const Eigen::MatrixXd &input, unsigned int n_threads) {
+                return simulateBatch(*sys.getRealization(), input, n_threads);
+             }, py::arg("input"), py::arg("n_threads") = 1, py::call_guard<py::gil_scoped_release>())
+        .def("simulateBatch", [](const LinearSystem &sys, const Eigen::MatrixXd &input, const Eigen::MatrixXd &initial_state,
+                                 unsigned int n_threads) {
+                return simulateBatch(*sys.getRealization(), input, initial_state, n_threads);
+             }, py::arg("input"), py::arg("initial_state"), py::arg("n_threads") = 1, py::call_guard<py::gil_scoped_release>())
+        .def("simulateParallelInTime", [](const LinearSystem &sys, const Eigen::VectorXd &input, unsigned int n_threads) {
+                return simulateParallelInTime(*sys.getRealization(), input, n_threads);
+             }, py::arg("input"), py::arg("n_threads") = 1, py::call_guard<py::gil_scoped_release>())
+        .def("simulateParallelInTime", [](const LinearSystem &sys, const Eigen::VectorXd &input,
+                                          const Eigen::VectorXd &initial_state, unsigned int n_threads) {
+                return simulateParallelInTime(*sys.getRealization(), input, initial_state, n_threads);
+             }, py::arg("input"), py::arg("initial_state"), py::arg("n_threads") = 1, py::call_guard<py::gil_scoped_release>())
+        .def("setState", static_cast<void (LinearSystem::*)(const Eigen::MatrixXd &)>(&LinearSystem::setState))
+        .def("__mul__", [](const LinearSystem &second, const LinearSystem &first) {return second * first;})
+        .def("__add__", [](const LinearSystem &first, const LinearSystem &second) {return first + second;})
+        .def("__sub__", [](const LinearSystem &first, const LinearSystem &second) {return first - second;})
+    ;
+
+    py::class_<Decimator>(m, "Decimator")
+        .def(py::init([](const LinearSystem &sys, unsigned int factor, unsigned int n_filters) {
+                return Decimator(sys.getRealization(), factor, n_filters);
+             }),
+             py::arg("system"),
+             py::arg("factor"),
+             py::arg("n_filters") = 1)
+        .def("reset", &Decimator::reset)
+        .def("update", [](Decimator &dec, const Eigen::RowVectorXd &input) {return dec.update(input);})
+        .def("process", [](Decimator &dec, const Eigen::MatrixXd &input) {
+                Eigen::MatrixXd output;
+                dec.process(input, output);
+                return output;
+             }, py::call_guard<py::gil_scoped_release>())
+        .def("getOutput", [](const Decimator &dec) {return Output(dec.getOutput());})
+        .def("getFactor", &Decimator::getFactor)
+        .def("getNFilters", &Decimator::getNFilters)
+        .def("getOutputSampling", &Decimator::getOutputSampling)
+        .def("isPolyphase", &Decimator::isPolyphase)
+    ;
+
+    py::class_<CoefficientBank>(m, "CoefficientBank")
+        .def(py::init([](const std::vector<LinearSystem> &systems) {return CoefficientBank(realizations(systems));}),
+             py::arg("systems"))
+        .def("update", [](CoefficientBank &bank, const Eigen::VectorXd &input) {
+                Eigen::VectorXd output(bank.getNFilters());
+                bank.update(input, output);
+                return output;
+             }, py::call_guard<py::gil_scoped_release>())
+        .def("process", &processBank, py::arg("input"), py::call_guard<py::gil_scoped_release>())
+        .def("reset", &CoefficientBank::reset)
+        .def("getState", &CoefficientBank::getState)
+        .def("setState", &CoefficientBank::setState)
+        .def("getNFilters", &CoefficientBank::getNFilters)
+        .def("getOrder", &CoefficientBank::getOrder)
+        .def("getSampling", &CoefficientBank::getSampling)
+    ;
+
+    py::class_<Builder>(m, "Builder")
+        .def_static("createSecondOrder", &Builder::createSecondOrder, py::arg("damp"), py::arg("cutoff"))
+        .def_static("createReferenceFilter2I", static_cast<LinearSystem (*)(double, double, double)>(&Builder::createReferenceFilter2I),
+                    py::arg("kp"), py::arg("ki"), py::arg("kd"))
+        .def_static("createReferenceFilter2I", static_cast<LinearSystem (*)(double, double)>(&Builder::createReferenceFilter2I),
+                    py::arg("kp"), py::arg("kd"))
+        .def_static("createReferenceFilterI", &Builder::createReferenceFilterI, py::arg("kp"), py::arg("ki"))
+        .def_static("createDecimator", &Builder::createDecimator, py::arg("factor"), py::arg("ts"))
+        .def_static("createMovingAverageDecimator", &Builder::createMovingAverageDecimator, py::arg("factor"), py::arg("ts"))
+        .def_static("createSecondOrderBank", &Builder::createSecondOrderBank,
+                    py::arg("damp"), py::arg("cutoff"), py::arg("ts") = Builder::default_sampling, py::call_guard<py::gil_scoped_release>())
+        .def_static("createReferenceFilter2IBank",
+                    static_cast<CoefficientBank (*)(const Eigen::VectorXd &, const Eigen::VectorXd &, const Eigen::VectorXd &, double)>(
+                        &Builder::createReferenceFilter2IBank),
+                    py::arg("kp"), py::arg("ki"), py::arg("kd"), py::arg("ts") = Builder::default_sampling, py::call_guard<py::gil_scoped_release>())
+        .def_static("createReferenceFilter2IBank",
+                    static_cast<CoefficientBank (*)(const Eigen::VectorXd &, const Eigen::VectorXd &, double)>(
+                        &Builder::createReferenceFilter2IBank),
+                    py::arg("kp"), py::arg("kd"), py::arg("ts") = Builder::default_sampling, py::call_guard<py::gil_scoped_release>())
+        .def_static("createReferenceFilterIBank", &Builder::createReferenceFilterIBank,
+                    py::arg("kp"), py::arg("ki"), py::arg("ts") = Builder::default_sampling, py::call_guard<py::gil_scoped_release>())
+    ;
+
+    py::class_<MIMOSystem>(m, "MIMOSystem")
+        .def(py::init([](const Eigen::MatrixXd &A, const Eigen::MatrixXd &B, const Eigen::MatrixXd &C,
+                         const Eigen::MatrixXd &D, double ts, IntegrationMethod method, double prewarp) {
+                return MIMOSystem(std::make_shared<const MIMORealization>(A, B, C, D, ts, method, prewarp));
+             }),
+             py::arg("A"), py::arg("B"), py::arg("C"), py::arg("D"),
+             py::arg("ts") = 0.001,
+             py::arg("integration_method") = TUSTIN,
+             py::arg("prewarp") = 0)
+        .def("update", [](MIMOSystem &sys, const Eigen::VectorXd &input) {return Eigen::VectorXd(sys.update(input));})
+        .def("process", [](MIMOSystem &sys, const Eigen::MatrixXd &input) {
+                Eigen::MatrixXd output;
+                sys.process(input, output);
+                return output;
+             }, py::call_guard<py::gil_scoped_release>())
+        .def("getOutput", [](const MIMOSystem &sys) {return Eigen::VectorXd(sys.getOutput());})
+        .def("getState", [](const MIMOSystem &sys) {return Eigen::VectorXd(sys.getState());})
+        .def("setState", [](MIMOSystem &sys, const Eigen::VectorXd &state) {sys.setState(state);})
+    ;
+
+    m.def("continuousResponse", [](const std::vector<LinearSystem> &systems, const Eigen::VectorXd &omega, unsigned int n_threads) {
+            return continuousResponse(realizations(systems), omega, n_threads);
+          }, py::arg("systems"), py::arg("omega"), py::arg("n_threads") = 1);
+    m.def("discreteResponse", [](const std::vector<LinearSystem> &systems, const Eigen::VectorXd &omega, unsigned int n_threads) {
+            return discreteResponse(realizations(systems), omega, n_threads);
+          }, py::arg("systems"), py::arg("omega"), py::arg("n_threads") = 1);
+
+    py::class_<VariableStepSystem>(m, "VariableStepSystem")
+        .def(py::init([](const LinearSystem &sys, Time quantum) {
+                return VariableStepSystem(sys.getRealization(), quantum);
+             }), py::arg("system"), py::arg("quantum") = 1)
+        .def("useNFilters", &VariableStepSystem::useNFilters)
+        .def("setInitialTime", &VariableStepSystem::setInitialTime)
+        .def("update", [](VariableStepSystem &sys, const Eigen::VectorXd &input, Time time) {
+                return Eigen::VectorXd(sys.update(input.transpose(), time));
+             }, py::call_guard<py::gil_scoped_release>())
+        .def("getNFilters", &VariableStepSystem::getNFilters)
+        .def("getOrder", &VariableStepSystem::getOrder)
+        .def("getQuantum", &VariableStepSystem::getQuantum)
+        .def("getCacheSize", &VariableStepSystem::getCacheSize)
+        .def("getOutput", [](const VariableStepSystem &sys) {return Eigen::VectorXd(sys.getOutput());})
+        .def("getState", [](const VariableStepSystem &sys) {return Eigen::MatrixXd(sys.getState());})
+        .def("setState", &VariableStepSystem::setState)
+    ;
+
+    py::class_<Unwrapper>(m, "Unwrapper")
+        .def(py::init<unsigned int>(), py::arg("n_channels") = 1)
+        .def("reset", &Unwrapper::reset)
+        .def("update", [](Unwrapper &unwrapper, const Eigen::VectorXd &angles) {
+                Eigen::VectorXd unwrapped(angles.size());
+                unwrapper.update(angles, unwrapped);
+                return unwrapped;
+             })
+        .def("process", [](Unwrapper &unwrapper, const Eigen::MatrixXd &input) {
+                Eigen::MatrixXd output;
+                unwrapper.process(input, output);
+                return output;
+             }, py::arg("input"), py::call_guard<py::gil_scoped_release>())
+        .def("getNChannels", &Unwrapper::getNChannels)
+        .def("getTurns", [](const Unwrapper &unwrapper) {return Eigen::VectorXd(unwrapper.getTurns());})
+    ;
+
+    py::class_<StepMetrics>(m, "StepMetrics")
+        .def_readonly("rise_time", &StepMetrics::rise_time)
+        .def_readonly("overshoot", &StepMetrics::overshoot)
+        .def_readonly("settling_time", &StepMetrics::settling_time)
+        .def_readonly("final_value", &StepMetrics::final_value)
+    ;
+
+    m.def("stepResponseMetrics", [](const LinearSystem &sys, double duration, double band) {
+            return stepResponseMetrics(*sys.getRealization(), duration, band);
+          }, py::arg("system"), py::arg("duration"), py::arg("band") = 0.02);
+    m.def("filtfilt", [](const LinearSystem &sys, const Eigen::MatrixXd &input, int padlen, unsigned int n_threads) {
+            return filtfilt(*sys.getRealization(), input, padlen, n_threads);
+          }, py::arg("system"), py::arg("input"), py::arg("padlen") = -1, py::arg("n_threads") = 1,
+          py::call_guard<py::gil_scoped_release>());
+    m.def("wrap2pi", [](Eigen::MatrixXd angles) {
+            wrap2pi(angles);
+            return angles;
+          }, py::arg("angles"), py::call_guard<py::gil_scoped_release>());
+    m.def("series", static_cast<LinearSystem (*)(const LinearSystem &, const LinearSystem &)>(&series),
+          py::arg("first"), py::arg("second"));
+    m.def("parallel", static_cast<LinearSystem (*)(const LinearSystem &, const LinearSystem &, double)>(&parallel),
+          py::arg("first"), py::arg("second"), py::arg("sign") = 1);
+    m.def("feedback", static_cast<LinearSystem (*)(const LinearSystem &, const LinearSystem &, double)>(&feedback),
+          py::arg("forward"), py::arg("backward"), py::arg("sign") = -1);
+    m.def("minimalRealization", static_cast<LinearSystem (*)(const LinearSystem &, double)>(&minimalRealization),
+          py::arg("system"), py::arg("tolerance") = 1e-10);
+    m.def("cartesianGrid", &cartesianGrid, py::arg("axes"));
+    m.def("sweepSecondOrder", &sweepSecondOrder,
+          py::arg("grid"), py::arg("duration"), py::arg("band") = 0.02, py::arg("n_threads") = 1,
+          py::call_guard<py::gil_scoped_release>());
+    m.def("sweepReferenceFilter2I", &sweepReferenceFilter2I,
+          py::arg("grid"), py::arg("duration"), py::arg("band") = 0.02, py::arg("n_threads") = 1,
+          py::call_guard<py::gil_scoped_release>());
+
+    bindPending<Eigen::VectorXd>(m, "PendingVector");
+    bindPending<Eigen::MatrixXd>(m, "PendingMatrix");
+
+    // Tasks hold references to their filter, which the returned Pending keeps alive
+    py::class_<ThreadPool>(m, "ThreadPool")
+        .def(py::init<unsigned int>(), py::arg("n_threads") = 0)
+        .def("size", &ThreadPool::size)
+        .def("submitUpdate", [](ThreadPool &pool, LinearSystem &sys, const Eigen::RowVectorXd &input, Time time) {
+                return Pending<Eigen::VectorXd>(pool.submit([&sys, input, time]() {return update(sys, input, time);}));
+             }, py::arg("system"), py::arg("input"), py::arg("time"), py::keep_alive<0, 2>())
+        .def("submitProcess", [](ThreadPool &pool, LinearSystem &sys, const Eigen::MatrixXd &input, Time time) {
+                return Pending<Eigen::MatrixXd>(pool.submit([&sys, input, time]() {return process(sys, input, time);}));
+             }, py::arg("system"), py::arg("input"), py::arg("time"), py::keep_alive<0, 2>())
+        .def("submitProcess", [](ThreadPool &pool, CoefficientBank &bank, const Eigen::MatrixXd &input) {
+                return Pending<Eigen::MatrixXd>(pool.submit([&bank, input]() {return processBank(bank, input);}));
+             }, py::arg("bank"), py::arg("input"), py::keep_alive<0, 2>())
+    ;
+
+    py::class_<DesignCache, std::unique_ptr<DesignCache, py::nodelete>>(m, "DesignCache")
+        .def_static("instance", &DesignCache::instance, py::return_value_policy::reference)
+        .def("getHits", &DesignCache::getHits)
+        .def("getMisses", &DesignCache::getMisses)
+        .def("size", &DesignCache::size)
+        .def("clear", &DesignCache::clear)
     ;
 
 }
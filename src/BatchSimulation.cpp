@@ -0,0 +1,161 @@
+#include "BatchSimulation.hpp"
+#include "BlockFilter.hpp"
+#include "Parallel.hpp"
+#include <stdexcept>
+#include <vector>
+
+using namespace linear_system;
+
+namespace
+{
+
+// Scenarios per block; the states of a block stay in L1 across the whole trajectory
+const Eigen::Index block_size = 256;
+
+// Shortest segment worth giving to a thread when splitting one input in time
+const Eigen::Index min_segment = 4096;
+
+/* Runs scenarios [first, first + rows) */
+void simulateBlock(const DiscreteRealization &realization, const std::vector<MatrixEntry<> > &a_entries,
+    const Eigen::MatrixXd &input, const Eigen::MatrixXd *initial_state, Eigen::MatrixXd &output,
+    Eigen::Index first, Eigen::Index rows)
+{
+    BlockFilter filter(realization, a_entries, rows);
+    if (initial_state)
+        filter.setState(initial_state->middleRows(first, rows));
+    for (Eigen::Index k = 0; k < input.cols(); ++k)
+        filter.step(input.col(k).segment(first, rows), output.col(k).segment(first, rows));
+}
+
+Eigen::MatrixXd simulate(const DiscreteRealization &realization, const Eigen::MatrixXd &input,
+    const Eigen::MatrixXd *initial_state, unsigned int n_threads)
+{
+    std::vector<MatrixEntry<> > a_entries = nonzeroEntries(realization.getA());
+
+    Eigen::MatrixXd output(input.rows(), input.cols());
+    const long n_blocks = (input.rows() + block_size - 1) / block_size;
+    parallelFor(n_blocks, n_threads, [&](long begin, long end) {
+        for (long b = begin; b < end; ++b)
+        {
+            Eigen::Index first = b * block_size;
+            simulateBlock(realization, a_entries, input, initial_state, output,
+                          first, std::min(block_size, input.rows() - first));
+        }
+    });
+    return output;
+}
+
+/*
+ * Runs input samples [first, first + length) of a single channel from state x, leaving the
+ * final state in x. The outputs are only computed when \p output is given.
+ */
+void simulateSegment(const DiscreteRealization &realization, const std::vector<MatrixEntry<> > &a_entries,
+    const Eigen::VectorXd &input, Eigen::VectorXd *output, Eigen::Index first, Eigen::Index length,
+    Eigen::VectorXd &x)
+{
+    const Eigen::VectorXd &B = realization.getB();
+    const Eigen::RowVectorXd &C = realization.getC();
+    const double D = realization.getD();
+
+    Eigen::VectorXd next(x.size());
+    for (Eigen::Index k = first; k < first + length; ++k)
+    {
+        const double u = input(k);
+        if (output)
+            (*output)(k) = C.dot(x) + D * u;
+
+        for (Eigen::Index i = 0; i < x.size(); ++i)
+            next(i) = B(i) * u;
+        addProduct(a_entries, x, next);
+        x.swap(next);
+    }
+}
+
+/*
+ * A^exponent by repeated squaring, in extended precision since canonical realizations lose
+ * many digits over the squarings.
+ */
+typedef Eigen::Matrix<long double, Eigen::Dynamic, Eigen::Dynamic> ExtendedMatrix;
+
+ExtendedMatrix power(const Eigen::MatrixXd &A, Eigen::Index exponent)
+{
+    ExtendedMatrix result = ExtendedMatrix::Identity(A.rows(), A.cols()), square = A.cast<long double>();
+    for (; exponent > 0; exponent >>= 1)
+    {
+        if (exponent & 1)
+            result = result * square;
+        square = square * square;
+    }
+    return result;
+}
+
+Eigen::VectorXd simulateInTime(const DiscreteRealization &realization, const Eigen::VectorXd &input,
+    const Eigen::VectorXd &initial_state, unsigned int n_threads)
+{
+    std::vector<MatrixEntry<> > a_entries = nonzeroEntries(realization.getA());
+    const Eigen::Index n = input.size();
+    const long n_segments = std::max<long>(1, std::min<long>(resolveThreads(n_threads), n / min_segment));
+    const Eigen::Index length = (n + n_segments - 1) / n_segments;
+
+    Eigen::VectorXd output(n);
+    std::vector<Eigen::VectorXd> start(n_segments, initial_state);
+
+    // Segment t > 0 maps its initial state x to A^length x + end[t]; the first segment already
+    // knows its initial state, so it directly computes its outputs and its final state
+    std::vector<Eigen::VectorXd> end(n_segments, Eigen::VectorXd::Zero(initial_state.size()));
+    parallelFor(n_segments, n_threads, [&](long begin, long stop) {
+        for (long t = begin; t < stop; ++t)
+        {
+            if (t == 0)
+            {
+                end[0] = initial_state;
+                simulateSegment(realization, a_entries, input, &output, 0, std::min(length, n), end[0]);
+            }
+            else if (t + 1 < n_segments)
+                simulateSegment(realization, a_entries, input, nullptr, t * length, length, end[t]);
+        }
+    });
+
+    const ExtendedMatrix transition = power(realization.getA(), length);
+    for (long t = 1; t < n_segments; ++t)
+    {
+        start[t] = (t == 1) ? end[0] : Eigen::VectorXd((transition * start[t - 1].cast<long double>()).cast<double>()
+                                                       + end[t - 1]);
+    }
+
+    parallelFor(n_segments - 1, n_threads, [&](long begin, long stop) {
+        for (long t = begin + 1; t < stop + 1; ++t)
+            simulateSegment(realization, a_entries, input, &output, t * length, std::min(length, n - t * length), start[t]);
+    });
+    return output;
+}
+
+}
+
+Eigen::MatrixXd linear_system::simulateBatch(const DiscreteRealization &realization, const Eigen::MatrixXd &input,
+    unsigned int n_threads)
+{
+    return simulate(realization, input, nullptr, n_threads);
+}
+
+Eigen::MatrixXd linear_system::simulateBatch(const DiscreteRealization &realization, const Eigen::MatrixXd &input,
+    const Eigen::MatrixXd &initial_state, unsigned int n_threads)
+{
+    if (initial_state.rows() != input.rows() || initial_state.cols() != realization.getOrder())
+        throw std::logic_error("the initial state must have one row per scenario and one column per state");
+    return simulate(realization, input, &initial_state, n_threads);
+}
+
+Eigen::VectorXd linear_system::simulateParallelInTime(const DiscreteRealization &realization,
+    const Eigen::VectorXd &input, unsigned int n_threads)
+{
+    return simulateInTime(realization, input, Eigen::VectorXd::Zero(realization.getOrder()), n_threads);
+}
+
+Eigen::VectorXd linear_system::simulateParallelInTime(const DiscreteRealization &realization,
+    const Eigen::VectorXd &input, const Eigen::VectorXd &initial_state, unsigned int n_threads)
+{
+    if (initial_state.size() != realization.getOrder())
+        throw std::logic_error("the initial state must have one entry per state");
+    return simulateInTime(realization, input, initial_state, n_threads);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "DiscreteRealization.hpp"
+#include "MatrixEntries.hpp"
+#include <Eigen/Eigen>
+#include <vector>
+
+namespace linear_system
+{
+
+/*!
+ * \brief Runs one filter on a block of channels, keeping one column of states per state
+ * component so that every term of x[k+1] = A x[k] + B u[k] is an axpy across channels.
+ *
+ * Only the nonzero entries of A are visited. This is the kernel of simulateBatch and filtfilt;
+ * blocks of a few hundred channels keep their states in L1 across the whole trajectory.
+ */
+class BlockFilter
+{
+private:
+    const DiscreteRealization &realization;
+    const std::vector<MatrixEntry<> > &a_entries;
+    Eigen::MatrixXd x, next;
+
+public:
+    /** @brief \p rows channels at rest; \p a_entries must be the nonzero entries of A. */
+    BlockFilter(const DiscreteRealization &realization, const std::vector<MatrixEntry<> > &a_entries, Eigen::Index rows) :
+        realization(realization), a_entries(a_entries),
+        x(Eigen::MatrixXd::Zero(rows, realization.getOrder())), next(rows, realization.getOrder())
+    {
+    }
+
+    /** @brief Sets the (rows by order) states, one row per channel. */
+    template<typename Matrix>
+    void setState(const Matrix &state)
+    {
+        x = state;
+    }
+
+    /** @brief Starts every channel from the steady state of a constant input u. */
+    template<typename Vector>
+    void start(const Eigen::VectorXd &unit_state, const Vector &u)
+    {
+        x.noalias() = u * unit_state.transpose();
+    }
+
+    /** @brief y = Cx + Du, then x = Ax + Bu; \p y may alias \p u. */
+    template<typename InputVector, typename OutputVector>
+    void step(const InputVector &u, OutputVector &&y)
+    {
+        const Eigen::Index n = x.cols();
+        for (Eigen::Index i = 0; i < n; ++i)
+            next.col(i) = realization.getB()(i) * u;
+        for (const MatrixEntry<> &e : a_entries)
+            next.col(e.row) += e.value * x.col(e.col);
+
+        y = realization.getD() * u;
+        for (Eigen::Index j = 0; j < n; ++j)
+            y += realization.getC()(j) * x.col(j);
+        x.swap(next);
+    }
+};
+
+}
@@ -1,39 +1,143 @@
 #include "Builder.hpp"
 #include "HelperFunctions.hpp"
+#include "DesignCache.hpp"
 
 
 using namespace linear_system;
 
 
-LinearSystem Builder::createSecondOrder(double damp, double cutoff)
+namespace
+{
+
+void checkSizes(Eigen::Index a, Eigen::Index b, Eigen::Index c = -1)
 {
-    Poly num(3), den(3);
+    if (a == 0 || a != b || (c >= 0 && c != a))
+        throw std::logic_error("the parameter arrays must be nonempty and of the same size");
+}
+
+// Continuous-time (num, den) of each design, shared by the filters and the banks
+
+typedef std::pair<Poly, Poly> TransferFunction;
+
+TransferFunction secondOrder(double damp, double cutoff)
+{
+    TransferFunction tf(Poly(3), Poly(3));
     double wn = cutoff2resonant(cutoff, damp);
-    num << 0, wn*wn, 0;
-    den << 1, 2*damp*wn, wn*wn;
-    return LinearSystem(num, den);
+    tf.first << 0, wn*wn, 0;
+    tf.second << 1, 2*damp*wn, wn*wn;
+    return tf;
+}
+
+TransferFunction referenceFilter2I(double kp, double ki, double kd)
+{
+    TransferFunction tf(Poly(1), Poly(3));
+    tf.first << ki;
+    tf.second << kd, kp, ki;
+    return tf;
+}
+
+TransferFunction referenceFilter2I(double kp, double kd)
+{
+    TransferFunction tf(Poly(1), Poly(2));
+    tf.first << kp;
+    tf.second << kd, kp;
+    return tf;
+}
+
+TransferFunction referenceFilterI(double kp, double ki)
+{
+    TransferFunction tf(Poly(1), Poly(2));
+    tf.first << ki;
+    tf.second << kp, ki;
+    return tf;
+}
+
+std::shared_ptr<const DiscreteRealization> design(const TransferFunction &tf, double ts)
+{
+    return DesignCache::instance().get(tf.first, tf.second, ts, TUSTIN, 0);
+}
+
+}
+
+
+constexpr double Builder::default_sampling;
+
+LinearSystem Builder::createSecondOrder(double damp, double cutoff)
+{
+    return LinearSystem(design(secondOrder(damp, cutoff), default_sampling));
 }
 
 LinearSystem Builder::createReferenceFilter2I(double kp, double ki, double kd)
 {
-    Poly num(1), den(3);
-    num << ki;
-    den << kd, kp, ki;
-    return LinearSystem(num, den);
+    return LinearSystem(design(referenceFilter2I(kp, ki, kd), default_sampling));
 }
 
 LinearSystem Builder::createReferenceFilter2I(double kp, double kd)
 {
-    Poly num(1), den(2);
-    num << kp;
-    den << kd, kp;
-    return LinearSystem(num, den);
+    return LinearSystem(design(referenceFilter2I(kp, kd), default_sampling));
 }
 
 LinearSystem Builder::createReferenceFilterI(double kp, double ki)
 {
-    Poly num(1), den(2);
-    num << ki;
-    den << kp, ki;
-    return LinearSystem(num, den);
+    return LinearSystem(design(referenceFilterI(kp, ki), default_sampling));
+}
+
+Decimator Builder::createDecimator(unsigned int factor, double ts)
+{
+    if (factor == 0)
+        throw std::logic_error("the decimation factor must be at least 1");
+
+    double cutoff = 0.8 * M_PI / (factor * ts);
+    Poly num(1), den(3);
+    num << cutoff*cutoff;
+    den << 1, std::sqrt(2)*cutoff, cutoff*cutoff;
+    return Decimator(DesignCache::instance().get(num, den, ts, TUSTIN, cutoff), factor);
+}
+
+Decimator Builder::createMovingAverageDecimator(unsigned int factor, double ts)
+{
+    if (factor == 0)
+        throw std::logic_error("the decimation factor must be at least 1");
+
+    Poly num = Poly::Constant(factor, 1.0 / factor);
+    Poly den = Poly::Zero(factor);
+    den(0) = 1;
+    return Decimator(DesignCache::instance().get(num, den, ts, DIRECT, 0), factor);
+}
+
+CoefficientBank Builder::createSecondOrderBank(const Eigen::VectorXd &damp, const Eigen::VectorXd &cutoff, double ts)
+{
+    checkSizes(damp.size(), cutoff.size());
+    std::vector<std::shared_ptr<const DiscreteRealization> > realizations(damp.size());
+    for (Eigen::Index i = 0; i < damp.size(); ++i)
+        realizations[i] = design(secondOrder(damp(i), cutoff(i)), ts);
+    return CoefficientBank(realizations);
+}
+
+CoefficientBank Builder::createReferenceFilter2IBank(const Eigen::VectorXd &kp, const Eigen::VectorXd &ki,
+    const Eigen::VectorXd &kd, double ts)
+{
+    checkSizes(kp.size(), ki.size(), kd.size());
+    std::vector<std::shared_ptr<const DiscreteRealization> > realizations(kp.size());
+    for (Eigen::Index i = 0; i < kp.size(); ++i)
+        realizations[i] = design(referenceFilter2I(kp(i), ki(i), kd(i)), ts);
+    return CoefficientBank(realizations);
+}
+
+CoefficientBank Builder::createReferenceFilter2IBank(const Eigen::VectorXd &kp, const Eigen::VectorXd &kd, double ts)
+{
+    checkSizes(kp.size(), kd.size());
+    std::vector<std::shared_ptr<const DiscreteRealization> > realizations(kp.size());
+    for (Eigen::Index i = 0; i < kp.size(); ++i)
+        realizations[i] = design(referenceFilter2I(kp(i), kd(i)), ts);
+    return CoefficientBank(realizations);
+}
+
+CoefficientBank Builder::createReferenceFilterIBank(const Eigen::VectorXd &kp, const Eigen::VectorXd &ki, double ts)
+{
+    checkSizes(kp.size(), ki.size());
+    std::vector<std::shared_ptr<const DiscreteRealization> > realizations(kp.size());
+    for (Eigen::Index i = 0; i < kp.size(); ++i)
+        realizations[i] = design(referenceFilterI(kp(i), ki(i)), ts);
+    return CoefficientBank(realizations);
 }
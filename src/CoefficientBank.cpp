@@ -0,0 +1,102 @@
+#include "CoefficientBank.hpp"
+#include <stdexcept>
+
+using namespace linear_system;
+
+CoefficientBank::CoefficientBank(const std::vector<std::shared_ptr<const DiscreteRealization> > &realizations) :
+    CoefficientBank(realizations, nullptr)
+{
+}
+
+CoefficientBank::CoefficientBank(const std::vector<std::shared_ptr<const DiscreteRealization> > &realizations,
+    FilterArena &arena) :
+    CoefficientBank(realizations, &arena)
+{
+}
+
+CoefficientBank::CoefficientBank(const std::vector<std::shared_ptr<const DiscreteRealization> > &realizations,
+    FilterArena *arena) :
+    realizations(realizations), state(arena), next(arena)
+{
+    if (realizations.empty())
+        throw std::logic_error("received no realization, but CoefficientBank must implement at least one filter");
+    for (const std::shared_ptr<const DiscreteRealization> &r : realizations)
+    {
+        if (!r)
+            throw std::logic_error("received an empty realization");
+        if (r->getOrder() != realizations[0]->getOrder() || r->getSampling() != realizations[0]->getSampling())
+            throw std::logic_error("every filter of a bank must have the same order and sampling period");
+    }
+
+    const unsigned int n_filters = realizations.size(), order = realizations[0]->getOrder();
+    Ts = realizations[0]->getSampling();
+
+    // The sparsity pattern is the union of the patterns of every filter, which is the same
+    // for filters designed the same way
+    Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> pattern = Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic>::Zero(order, order);
+    for (const std::shared_ptr<const DiscreteRealization> &r : realizations)
+        pattern = pattern.array() || (r->getA().array() != 0);
+    for (unsigned int j = 0; j < order; ++j)
+    {
+        for (unsigned int i = 0; i < order; ++i)
+        {
+            if (pattern(i, j))
+                a_entries.push_back(Entry{i, j});
+        }
+    }
+
+    a_values.resize(n_filters, a_entries.size());
+    B.resize(n_filters, order);
+    C.resize(n_filters, order);
+    D.resize(n_filters);
+    for (unsigned int f = 0; f < n_filters; ++f)
+    {
+        const DiscreteRealization &r = *realizations[f];
+        for (std::size_t e = 0; e < a_entries.size(); ++e)
+            a_values(f, e) = r.getA()(a_entries[e].row, a_entries[e].col);
+        B.row(f) = r.getB().transpose();
+        C.row(f) = r.getC();
+        D(f) = r.getD();
+    }
+
+    state.resize(n_filters, order);
+    state.matrix().setZero();
+    next.resize(n_filters, order);
+}
+
+void CoefficientBank::update(const Eigen::Ref<const Eigen::VectorXd> &input, Eigen::Ref<Eigen::VectorXd> output)
+{
+    Eigen::Map<Eigen::MatrixXd> &x = state.matrix(), &next_x = next.matrix();
+    if (input.size() != x.rows() || output.size() != x.rows())
+        throw std::logic_error("the number of inputs and outputs must match the number of filters");
+    LINEAR_SYSTEM_PERF_SCOPE(profile.get(), PERF_UPDATE);
+
+    // Next x = Ax + Bu first: output may be input itself, which y overwrites
+    for (Eigen::Index i = 0; i < x.cols(); ++i)
+        next_x.col(i) = B.col(i).cwiseProduct(input);
+    for (std::size_t e = 0; e < a_entries.size(); ++e)
+        next_x.col(a_entries[e].row) += a_values.col(e).cwiseProduct(x.col(a_entries[e].col));
+
+    // y = Cx + Du, from the current x
+    output = D.cwiseProduct(input);
+    for (Eigen::Index j = 0; j < x.cols(); ++j)
+        output += C.col(j).cwiseProduct(x.col(j));
+    state.swap(next);
+}
+
+void CoefficientBank::process(const Eigen::MatrixXd &input, Eigen::MatrixXd &output)
+{
+    if (input.rows() != state.matrix().rows())
+        throw std::logic_error("the number of input channels is different from the number of filters");
+
+    output.resize(input.rows(), input.cols());
+    for (Eigen::Index k = 0; k < input.cols(); ++k)
+        update(input.col(k), output.col(k));
+}
+
+void CoefficientBank::setState(const Eigen::MatrixXd &state)
+{
+    if (state.rows() != this->state.matrix().rows() || state.cols() != this->state.matrix().cols())
+        throw std::logic_error("the state must have one row per filter and one column per state");
+    this->state.matrix() = state;
+}
@@ -0,0 +1,232 @@
+#include "ConvolutionEngine.hpp"
+#include "MatrixEntries.hpp"
+#include <unsupported/Eigen/FFT>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace linear_system;
+
+namespace
+{
+
+// Cost of a real FFT of size n, in multiply-adds per n log2(n), measured with the benchmarks
+const double fft_cost = 1.5;
+
+unsigned int nonzeros(const Eigen::MatrixXd &m)
+{
+    return (m.array() != 0).count();
+}
+
+/*
+ * Solution of Q = A' Q A + C' C, in the coordinates of the complex Schur form A = U T U^H: with
+ * T upper triangular, the j-th column of U^H Q U solves the lower triangular system
+ * (I - T_jj T^H) q_j = w_j + T^H sum_l<j q_l T_lj. Unlike sums of powers of A, which are
+ * swamped by rounding errors when poles cluster, this is backward stable.
+ */
+Eigen::MatrixXd observabilityGramian(const DiscreteRealization &realization)
+{
+    const Eigen::Index n = realization.getOrder();
+    if (n == 0)
+        return Eigen::MatrixXd(0, 0);
+    Eigen::ComplexSchur<Eigen::MatrixXd> schur(realization.getA());
+    if (schur.info() != Eigen::Success)
+        throw std::logic_error("could not compute the Schur form of the filter");
+    const Eigen::MatrixXcd &U = schur.matrixU(), &T = schur.matrixT();
+    if (T.diagonal().cwiseAbs().maxCoeff() >= 1)
+        throw std::logic_error("the impulse response does not decay, the filter must be stable");
+
+    const Eigen::RowVectorXcd cu = realization.getC() * U;
+    const Eigen::MatrixXcd w = cu.adjoint() * cu, Th = T.adjoint();
+    Eigen::MatrixXcd q(n, n), M(n, n);
+    Eigen::VectorXcd rhs(n);
+    for (Eigen::Index j = 0; j < n; ++j)
+    {
+        rhs = w.col(j);
+        if (j > 0)
+            rhs += Th * (q.leftCols(j) * T.col(j).head(j));
+        M = -T(j, j) * Th;
+        M.diagonal().array() += 1;
+        q.col(j) = M.triangularView<Eigen::Lower>().solve(rhs);
+    }
+    return (U * q * U.adjoint()).real();
+}
+
+}
+
+struct ConvolutionEngine::Partitions
+{
+    Eigen::FFT<double> fft;
+
+    /*! @brief Number of partitions of the impulse response */
+    unsigned int count;
+
+    /*! @brief (block_size+1 by count) half spectra of the zero-padded partitions */
+    Eigen::MatrixXcd spectra;
+
+    /*! @brief (block_size+1 by count*n_filters) spectra of the last count input blocks of each filter */
+    Eigen::MatrixXcd history;
+
+    /*! @brief Slot of #history holding the newest spectrum */
+    unsigned int head;
+
+    /*! @brief (block_size by n_filters) last input block of each filter */
+    Eigen::MatrixXd previous;
+
+    std::vector<double> buffer;
+    Eigen::VectorXcd sum;
+};
+
+ConvolutionEngine::ConvolutionEngine(std::shared_ptr<const DiscreteRealization> realization, unsigned int n_filters,
+    unsigned int block_size, ConvolutionMode mode, double tolerance) :
+    realization(std::move(realization)), n_filters(n_filters), block_size(block_size), mode(mode), impulse_length(0)
+{
+    if (!this->realization)
+        throw std::logic_error("received an empty realization");
+    if (n_filters == 0)
+        throw std::logic_error("received n_filters = 0, but ConvolutionEngine must implement at least one filter");
+    if (block_size == 0)
+        throw std::logic_error("the block size must be at least 1");
+    if (mode == OVERLAP_SAVE && block_size % 2 != 0)
+        throw std::logic_error("the FFT path needs an even block size");
+
+    Eigen::VectorXd impulse;
+    if (mode != RECURRENCE)
+    {
+        impulse = impulseResponse(*this->realization, tolerance);
+        if (mode == AUTOMATIC)
+            this->mode = selectMode(*this->realization, impulse.size(), block_size);
+    }
+
+    if (this->mode == RECURRENCE)
+    {
+        recurrence.reset(new DoubleFilterBank(this->realization, n_filters));
+        return;
+    }
+
+    impulse_length = impulse.size();
+    const unsigned int P = block_size;
+    partitions.reset(new Partitions);
+    Partitions &p = *partitions;
+    p.count = (impulse_length + P - 1) / P;
+    p.fft.SetFlag(Eigen::FFT<double>::HalfSpectrum);
+    p.buffer.assign(2 * P, 0);
+    p.spectra.resize(P + 1, p.count);
+    for (unsigned int k = 0; k < p.count; ++k)
+    {
+        // Partition k in the first half, zeros in the second
+        unsigned int length = std::min(P, impulse_length - k * P);
+        std::fill(p.buffer.begin(), p.buffer.end(), 0);
+        std::copy(impulse.data() + k * P, impulse.data() + k * P + length, p.buffer.begin());
+        p.fft.fwd(p.spectra.col(k).data(), p.buffer.data(), 2 * P);
+    }
+    p.history.resize(P + 1, p.count * n_filters);
+    p.previous.resize(P, n_filters);
+    p.sum.resize(P + 1);
+    reset();
+}
+
+ConvolutionEngine::~ConvolutionEngine()
+{
+}
+
+void ConvolutionEngine::reset()
+{
+    if (recurrence)
+        recurrence->reset();
+    if (partitions)
+    {
+        partitions->history.setZero();
+        partitions->previous.setZero();
+        partitions->head = 0;
+    }
+}
+
+void ConvolutionEngine::process(const Eigen::MatrixXd &input, Eigen::MatrixXd &output)
+{
+    if (input.rows() != n_filters)
+        throw std::logic_error("the number of input channels is different from the number of filters");
+    if (input.cols() % block_size != 0)
+        throw std::logic_error("the number of samples must be a multiple of the block size");
+
+    if (recurrence)
+    {
+        recurrence->process(input, output);
+        return;
+    }
+
+    // Overlap-save: the last half of IFFT(sum_k H_k X_{n-k}), where X_n is the spectrum of
+    // the previous and current blocks, is the linear convolution over the current block
+    Partitions &p = *partitions;
+    const unsigned int P = block_size, K = p.count;
+    output.resize(input.rows(), input.cols());
+    for (Eigen::Index start = 0; start < input.cols(); start += P)
+    {
+        p.head = (p.head + 1) % K;
+        for (unsigned int f = 0; f < n_filters; ++f)
+        {
+            Eigen::Map<Eigen::VectorXd> buffer(p.buffer.data(), 2 * P);
+            buffer.head(P) = p.previous.col(f);
+            buffer.tail(P) = input.row(f).segment(start, P).transpose();
+            p.previous.col(f) = buffer.tail(P);
+
+            p.fft.fwd(p.history.col(f * K + p.head).data(), p.buffer.data(), 2 * P);
+            p.sum = p.spectra.col(0).cwiseProduct(p.history.col(f * K + p.head));
+            for (unsigned int k = 1; k < K; ++k)
+                p.sum += p.spectra.col(k).cwiseProduct(p.history.col(f * K + (p.head + K - k) % K));
+
+            p.fft.inv(p.buffer.data(), p.sum.data(), 2 * P);
+            output.row(f).segment(start, P) = buffer.tail(P).transpose();
+        }
+    }
+}
+
+Eigen::VectorXd ConvolutionEngine::impulseResponse(const DiscreteRealization &realization, double tolerance,
+    unsigned int max_length)
+{
+    // h_0 = D and h_k = C A^(k-1) B, visiting only the nonzero entries of A
+    const unsigned int n = realization.getOrder();
+    const std::vector<MatrixEntry<> > a_entries = nonzeroEntries(realization.getA());
+    // From the state v = A^(k-1) B, the energy of all the remaining samples h_k, h_k+1, ... is
+    // exactly v' Q v, with Q the observability Gramian
+    const Eigen::MatrixXd Q = observabilityGramian(realization);
+    // Margin for the rounding errors of Q and of v' Q v, relative to |v|^2
+    const double rounding = 4 * (n + 1) * std::numeric_limits<double>::epsilon() * Q.norm();
+
+    std::vector<double> impulse(1, realization.getD());
+    double l1 = std::abs(realization.getD());
+    Eigen::VectorXd v = realization.getB(), next(n), qv(n);
+    for (;;)
+    {
+        // Every later sample, and the L2 norm of the whole tail, is bounded by sqrt(v' Q v)
+        qv.noalias() = Q * v;
+        double energy = v.dot(qv) + rounding * v.squaredNorm();
+        if (!std::isfinite(energy) || impulse.size() >= max_length)
+            throw std::logic_error("the impulse response does not decay, the filter must be stable");
+        if (energy <= tolerance * tolerance * l1 * l1 || energy == 0)
+            break;
+
+        impulse.push_back(realization.getC().dot(v));
+        l1 += std::abs(impulse.back());
+        next.setZero();
+        addProduct(a_entries, v, next);
+        v.swap(next);
+    }
+    return Eigen::Map<Eigen::VectorXd>(impulse.data(), impulse.size());
+}
+
+ConvolutionMode ConvolutionEngine::selectMode(const DiscreteRealization &realization, unsigned int impulse_length,
+    unsigned int block_size)
+{
+    if (block_size % 2 != 0)
+        return RECURRENCE;
+
+    double recursion = nonzeros(realization.getA()) + (realization.getB().array() != 0).count()
+        + (realization.getC().array() != 0).count() + 1;
+
+    const double P = block_size, N = 2 * P;
+    const double partitions = std::ceil(impulse_length / P);
+    double convolution = (2 * fft_cost * N * std::log2(N) + 4 * partitions * (P + 1)) / P;
+    return (convolution < recursion) ? OVERLAP_SAVE : RECURRENCE;
+}
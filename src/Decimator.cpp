@@ -0,0 +1,81 @@
+#include "Decimator.hpp"
+#include <stdexcept>
+
+using namespace linear_system;
+
+Decimator::Decimator(std::shared_ptr<const DiscreteRealization> realization, unsigned int factor, unsigned int n_filters) :
+    realization(std::move(realization)), position(0), factor(factor), countdown(0), n_filters(n_filters), fir(false)
+{
+    if (!this->realization)
+        throw std::logic_error("received an empty realization");
+    if (factor == 0)
+        throw std::logic_error("the decimation factor must be at least 1");
+    if (n_filters == 0)
+        throw std::logic_error("received n_filters = 0, but Decimator must implement at least one filter");
+
+    fir = this->realization->isFIR();
+    if (fir)
+        taps = this->realization->getNumerator().reverse();
+    reset();
+}
+
+void Decimator::reset()
+{
+    fstate.reset(n_filters, fir ? 0 : realization->getOrder());
+    last_output.setZero(n_filters);
+    if (fir)
+        history.setZero(n_filters, 2 * taps.size());
+    position = 0;
+    countdown = 0;
+}
+
+bool Decimator::update(const Input &signalIn)
+{
+    if (signalIn.size() != n_filters)
+        throw std::logic_error("the number of inputs is different from the number of filters");
+
+    bool ready = (countdown == 0);
+    if (fir)
+    {
+        const unsigned int length = taps.size();
+        history.col(position) = signalIn.transpose();
+        history.col(position + length) = signalIn.transpose();
+        if (ready)
+            last_output.noalias() = history.middleCols(position + 1, length) * taps;
+        position = (position + 1 == length) ? 0 : position + 1;
+    }
+    else
+    {
+        if (ready)
+        {
+            realization->output(fstate, signalIn);
+            last_output = fstate.last_output;
+        }
+        realization->advance(fstate, signalIn);
+    }
+
+    countdown = ready ? factor - 1 : countdown - 1;
+    return ready;
+}
+
+unsigned int Decimator::process(const Eigen::MatrixXd &input, Eigen::MatrixXd &output)
+{
+    if (input.rows() != n_filters)
+        throw std::logic_error("the number of input channels is different from the number of filters");
+
+    // Number of outputs due within this block
+    unsigned int n_outputs = 0;
+    if (input.cols() > countdown)
+        n_outputs = (input.cols() - countdown - 1) / factor + 1;
+    output.resize(n_filters, n_outputs);
+
+    unsigned int k = 0;
+    sample.resize(n_filters);
+    for (Eigen::Index i = 0; i < input.cols(); ++i)
+    {
+        sample = input.col(i).transpose();
+        if (update(sample))
+            output.col(k++) = last_output;
+    }
+    return n_outputs;
+}
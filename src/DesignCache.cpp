@@ -0,0 +1,118 @@
+#include "DesignCache.hpp"
+#include <algorithm>
+
+using namespace linear_system;
+
+bool DesignCache::Key::operator<(const Key &other) const
+{
+    if (ts != other.ts)
+        return ts < other.ts;
+    if (method != other.method)
+        return method < other.method;
+    if (prewarp != other.prewarp)
+        return prewarp < other.prewarp;
+    if (form != other.form)
+        return form < other.form;
+    if (den != other.den)
+        return den < other.den;
+    return num < other.num;
+}
+
+namespace
+{
+
+// Expired entries are dropped whenever the map reaches twice the size it had after the last
+// sweep, so that inserting many designs stays linear
+const std::size_t min_sweep_size = 64;
+
+}
+
+DesignCache::DesignCache() : sweep_size(min_sweep_size), hits(0), misses(0)
+{
+}
+
+DesignCache & DesignCache::instance()
+{
+    static DesignCache cache;
+    return cache;
+}
+
+std::shared_ptr<const DiscreteRealization> DesignCache::get(const Poly &num, const Poly &den, double ts,
+    IntegrationMethod method, double prewarp, RealizationForm form)
+{
+    Poly norm_num, norm_den;
+    DiscreteRealization::normalize(num, den, norm_num, norm_den);
+
+    Key key;
+    key.num.assign(norm_num.data(), norm_num.data() + norm_num.size());
+    key.den.assign(norm_den.data(), norm_den.data() + norm_den.size());
+    key.ts = ts;
+    key.method = method;
+    key.prewarp = (method == TUSTIN) ? prewarp : 0;
+    key.form = form;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = designs.find(key);
+        if (it != designs.end())
+        {
+            std::shared_ptr<const DiscreteRealization> design = it->second.lock();
+            if (design)
+            {
+                ++hits;
+                return design;
+            }
+        }
+    }
+
+    // Build outside the lock so that different designs can be computed concurrently
+    std::shared_ptr<const DiscreteRealization> design =
+        std::make_shared<const DiscreteRealization>(norm_num, norm_den, ts, method, prewarp, form);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<const DiscreteRealization> &slot = designs[key];
+    std::shared_ptr<const DiscreteRealization> existing = slot.lock();
+    if (existing)
+    {
+        // Another thread built the same design in the meantime
+        ++hits;
+        return existing;
+    }
+    ++misses;
+    slot = design;
+
+    // Drop entries whose designs are no longer used by anyone
+    if (designs.size() >= sweep_size)
+    {
+        for (auto it = designs.begin(); it != designs.end(); )
+        {
+            if (it->second.expired())
+                it = designs.erase(it);
+            else
+                ++it;
+        }
+        sweep_size = std::max(min_sweep_size, 2 * designs.size());
+    }
+    return design;
+}
+
+std::size_t DesignCache::size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t ret = 0;
+    for (auto it = designs.begin(); it != designs.end(); ++it)
+    {
+        if (!it->second.expired())
+            ++ret;
+    }
+    return ret;
+}
+
+void DesignCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    designs.clear();
+    sweep_size = min_sweep_size;
+    hits = 0;
+    misses = 0;
+}
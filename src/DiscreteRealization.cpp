@@ -0,0 +1,492 @@
+#include "DiscreteRealization.hpp"
+#include "HelperFunctions.hpp"
+#include "MIMORealization.hpp"
+#include "PerfEvents.hpp"
+#include "Polynomial.hpp"
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace linear_system;
+
+void DiscreteRealization::normalize(const Poly &num, const Poly &den, Poly &norm_num, Poly &norm_den)
+{
+    if (den.size() == 0)
+        throw std::logic_error("invalid system order, since there are no denominator coefficients to set");
+
+    if (num.size() > den.size())
+        throw std::logic_error("the numerator order should not be higher than the denominator order");
+
+    if (den(0) == 0)
+        throw std::logic_error("denominator's first term can't be zero");
+
+    // Make sure the numerator has as many coefficients as the denominator, even
+    // if some of the higher terms are zero
+    norm_num.setZero(den.size());
+    norm_num.tail(num.size()) = num;
+
+    // Normalize vectors such that the denominator is monic
+    norm_num /= den(0);
+    norm_den = den / den(0);
+}
+
+DiscreteRealization::DiscreteRealization(const Poly &num, const Poly &den, double ts, IntegrationMethod method, double prewarp,
+    RealizationForm form) :
+    D(0), Ts(ts), integration_method(method), prewarp_frequency(prewarp), form(form)
+{
+    if (ts <= 0.0)
+        throw std::logic_error("non positive sampling time given");
+    // The prewarp frequency is ignored, unchecked, by the other methods
+    if (integration_method != TUSTIN)
+        prewarp_frequency = 0;
+    else if (prewarp < 0)
+        throw std::invalid_argument("prewarp frequency must be nonnegative");
+
+    normalize(num, den, tf_num, tf_den);
+
+    // Set the filter order
+    order = tf_den.size() - 1;
+
+    // Reset state matrices
+    A.setZero(order,order);
+    B.setZero(order);
+    C.setZero(order);
+
+    if (integration_method == DIRECT)
+    {
+        // The coefficients are already in discrete time
+        tf2ss();
+    }
+    else
+    {
+        cont_num = tf_num;
+        cont_den = tf_den;
+
+        // Discretize system
+        discretize();
+    }
+    transform();
+}
+
+DiscreteRealization::DiscreteRealization(const Eigen::MatrixXd &A, const Eigen::VectorXd &B, const Eigen::RowVectorXd &C,
+    double D, double ts, RealizationForm form) :
+    A(A), B(B), C(C), D(D), order(A.rows()), Ts(ts), integration_method(DIRECT), prewarp_frequency(0), form(form)
+{
+    if (ts <= 0.0)
+        throw std::logic_error("non positive sampling time given");
+    if (A.cols() != A.rows() || B.size() != A.rows() || C.size() != A.rows())
+        throw std::logic_error("the state-space matrices have inconsistent dimensions");
+
+    // For a SISO system, C adj(zI - A) B = det(zI - A + BC) - det(zI - A)
+    tf_den = CharacteristicPolynomial(A);
+    tf_num = CharacteristicPolynomial(A - B * C) + (D - 1) * tf_den;
+
+    if (form == CONTROLLABLE_CANONICAL)
+        tf2ss();
+    else if (form != STATE_SPACE)
+        transform();
+}
+
+bool DiscreteRealization::isFIR() const
+{
+    return order == 0 || tf_den.tail(order).cwiseAbs().maxCoeff() == 0;
+}
+
+namespace
+{
+
+/*!
+ * Substitutes s = (alpha z + beta) / (gamma z + delta) in poly, in place. The per-thread
+ * buffers only grow, so repeated designs don't allocate.
+ */
+void substitute(Poly &poly, double alpha, double beta, double gamma, double delta)
+{
+    static thread_local Eigen::VectorXd buffer, scratch;
+    const Eigen::Index n = poly.size();
+    if (buffer.size() < n)
+    {
+        buffer.resize(n);
+        scratch.resize(n);
+    }
+    Eigen::VectorBlock<Eigen::VectorXd> out = buffer.head(n), powers = scratch.head(n);
+    polynomial::substitute(poly, alpha, beta, gamma, delta, out, powers);
+    poly = out;
+}
+
+}
+
+void DiscreteRealization::convertFwdEuler(Poly &poly) const
+{
+    // s = (z - 1) / Ts
+    substitute(poly, 1, -1, 0, Ts);
+}
+
+void DiscreteRealization::convertBwdEuler(Poly &poly) const
+{
+    // s = (z - 1) / (Ts z)
+    substitute(poly, 1, -1, Ts, 0);
+}
+
+void DiscreteRealization::convertTustin(Poly &poly) const
+{
+    // s = a (z - 1) / (z + 1)
+    double tustin_a = (prewarp_frequency != 0) ? prewarp_frequency / tan(prewarp_frequency * Ts / 2) : 2 / Ts;
+    substitute(poly, tustin_a, -tustin_a, 1, 1);
+}
+
+void DiscreteRealization::discretize()
+{
+    LINEAR_SYSTEM_PERF_SCOPE(&PerfProfile::global(), PERF_DISCRETIZE);
+    switch(integration_method)
+    {
+    case FORWARD_EULER:
+        this->convertFwdEuler(tf_num);
+        this->convertFwdEuler(tf_den);
+        break;
+    case BACKWARD_EULER:
+        this->convertBwdEuler(tf_num);
+        this->convertBwdEuler(tf_den);
+        break;
+    case TUSTIN:
+        this->convertTustin(tf_num);
+        this->convertTustin(tf_den);
+        break;
+    case ZOH:
+    case FOH:
+    case IMPULSE_INVARIANT:
+        discretizeExact();
+        return;
+    default: throw std::logic_error("invalid integration method");
+    }
+    tf_num /= tf_den(0);
+    tf_den /= tf_den(0);
+    tf2ss();
+}
+
+void DiscreteRealization::discretizeExact()
+{
+    Eigen::MatrixXd Ac;
+    Eigen::VectorXd Bc;
+    Eigen::RowVectorXd Cc;
+    double Dc;
+    tf2ss(cont_num, cont_den, Ac, Bc, Cc, Dc);
+
+    Eigen::MatrixXd Ad, Bd, Cd, Dd;
+    MIMORealization::discretize(Ac, Bc, Cc, Eigen::MatrixXd::Constant(1, 1, Dc), Ts, integration_method,
+                                prewarp_frequency, Ad, Bd, Cd, Dd);
+    A = Ad;
+    B = Bd.col(0);
+    C = Cd.row(0);
+    D = Dd(0, 0);
+
+    // For a SISO system, C adj(zI - A) B = det(zI - A + BC) - det(zI - A)
+    tf_den = CharacteristicPolynomial(A);
+    tf_num = CharacteristicPolynomial(A - B * C) + (D - 1) * tf_den;
+}
+
+void DiscreteRealization::transform()
+{
+    if (order == 0 || form == CONTROLLABLE_CANONICAL)
+        return;
+    if (form != MODAL && form != BALANCED)
+        throw std::logic_error("invalid realization form");
+
+    // Balancing starts from the modal form when possible, which is much better conditioned
+    bool modal = toModal();
+    if (form == MODAL && !modal)
+        throw std::logic_error("the modal form requires a filter with distinct poles");
+    if (form == BALANCED)
+        toBalanced();
+}
+
+bool DiscreteRealization::toModal()
+{
+    const Poly &num = hasContinuousModel() ? cont_num : tf_num;
+    const Poly &den = hasContinuousModel() ? cont_den : tf_den;
+
+    Eigen::VectorXcd poles = polynomial::roots(den);
+
+    // H = num(0) + sum r_i / (p - p_i), with r_i = num(p_i) / prod_{j != i} (p_i - p_j)
+    Eigen::VectorXcd residues(order);
+    for (unsigned int i = 0; i < order; ++i)
+    {
+        std::complex<double> value = 0, derivative = 1;
+        for (unsigned int k = 0; k <= order; ++k)
+            value = value * poles(i) + num(k);
+        for (unsigned int j = 0; j < order; ++j)
+        {
+            if (j == i)
+                continue;
+            std::complex<double> gap = poles(i) - poles(j);
+            if (std::abs(gap) <= 1e-6 * std::max(std::abs(poles(i)), std::abs(poles(j))) || gap == 0.0)
+                return false;
+            derivative *= gap;
+        }
+        residues(i) = value / derivative;
+    }
+
+    // A real pole gets a 1x1 block; a pair p = s + jw gets [s w; -w s], whose state x1 - j x2
+    // follows the complex mode, so the pair contributes Re((c1 + j c2)(b1 - j b2) / (z - p)).
+    // Input and output gains are split evenly.
+    Eigen::MatrixXd modal_A = Eigen::MatrixXd::Zero(order, order);
+    Eigen::VectorXd modal_B = Eigen::VectorXd::Zero(order);
+    Eigen::RowVectorXd modal_C = Eigen::RowVectorXd::Zero(order);
+    mode_sizes.clear();
+    for (unsigned int i = 0; i < order; )
+    {
+        if (poles(i).imag() == 0)
+        {
+            double r = residues(i).real(), gain = std::sqrt(std::abs(r));
+            modal_A(i, i) = poles(i).real();
+            modal_B(i) = gain;
+            modal_C(i) = (gain > 0) ? r / gain : 0;
+            mode_sizes.push_back(1);
+            i += 1;
+        }
+        else
+        {
+            std::complex<double> g = 2.0 * residues(i);
+            double gain = std::sqrt(std::abs(g));
+            modal_A(i, i) = modal_A(i+1, i+1) = poles(i).real();
+            modal_A(i, i+1) = poles(i).imag();
+            modal_A(i+1, i) = -poles(i).imag();
+            modal_B(i) = gain;
+            modal_C(i) = (gain > 0) ? g.real() / gain : 0;
+            modal_C(i+1) = (gain > 0) ? g.imag() / gain : 0;
+            mode_sizes.push_back(2);
+            i += 2;
+        }
+    }
+
+    if (!hasContinuousModel())
+    {
+        A = modal_A;
+        B = modal_B;
+        C = modal_C;
+        return true;
+    }
+
+    // Every method maps a block-diagonal realization to a block-diagonal one
+    Eigen::MatrixXd Ad, Bd, Cd, Dd;
+    MIMORealization::discretize(modal_A, modal_B, modal_C, Eigen::MatrixXd::Constant(1, 1, num(0)), Ts,
+                                integration_method, prewarp_frequency, Ad, Bd, Cd, Dd);
+    A.setZero(order, order);
+    for (unsigned int i = 0, k = 0; k < mode_sizes.size(); i += mode_sizes[k++])
+        A.block(i, i, mode_sizes[k], mode_sizes[k]) = Ad.block(i, i, mode_sizes[k], mode_sizes[k]);
+    B = Bd.col(0);
+    C = Cd.row(0);
+    D = Dd(0, 0);
+    return true;
+}
+
+void DiscreteRealization::toBalanced()
+{
+    // Gramians P = sum A^k B B' A'^k and Q = sum A'^k C' C A^k, by doubling
+    Eigen::MatrixXd P = B * B.transpose(), Q = C.transpose() * C, Ak = A;
+    bool converged = false;
+    for (int k = 0; k < 64 && !converged; ++k)
+    {
+        P += Ak * P * Ak.transpose();
+        Q += Ak.transpose() * Q * Ak;
+        Ak = Ak * Ak;
+        converged = (Ak.cwiseAbs().maxCoeff() < 1e-18);
+        if (!Ak.allFinite())
+            break;
+    }
+    if (!converged)
+        throw std::logic_error("the balanced form requires a stable filter");
+
+    Eigen::LLT<Eigen::MatrixXd> chol_P(P), chol_Q(Q);
+    if (chol_P.info() != Eigen::Success || chol_Q.info() != Eigen::Success)
+        throw std::logic_error("the balanced form requires a minimal realization (no pole-zero cancellations)");
+    Eigen::MatrixXd Lc = chol_P.matrixL(), Lo = chol_Q.matrixL();
+    // With Lo' Lc = U S V', T = Lc V S^-1/2 makes both Gramians equal to S
+    Eigen::JacobiSVD<Eigen::MatrixXd, Eigen::NoQRPreconditioner> svd(Lo.transpose() * Lc, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    Eigen::VectorXd s = svd.singularValues().cwiseSqrt().cwiseInverse();
+    if (!s.allFinite())
+        throw std::logic_error("the balanced form requires a minimal realization (no pole-zero cancellations)");
+    Eigen::MatrixXd T = Lc * svd.matrixV() * s.asDiagonal();
+    Eigen::MatrixXd T_inv = s.asDiagonal() * svd.matrixU().transpose() * Lo.transpose();
+
+    A = T_inv * A * T;
+    B = T_inv * B;
+    C = C * T;
+}
+
+void DiscreteRealization::tf2ss()
+{
+    tf2ss(tf_num, tf_den, A, B, C, D);
+}
+
+void DiscreteRealization::tf2ss(const Poly &tf_num, const Poly &tf_den, Eigen::MatrixXd &A, Eigen::VectorXd &B,
+    Eigen::RowVectorXd &C, double &D)
+{
+    LINEAR_SYSTEM_PERF_SCOPE(&PerfProfile::global(), PERF_TF2SS);
+    unsigned int order = tf_den.size() - 1;
+    A.setZero(order, order);
+    B.setZero(order);
+    C.setZero(order);
+    D = 0;
+
+    if (order == 0)
+    {
+        D = tf_num[0];
+        return;
+    }
+
+    // With num and den of the same size, the synthetic division of a proper transfer function
+    // has a single step: D = num(0) / den(0), and the remainder num - D den goes to C
+    if (polynomial::degree(tf_num) == polynomial::degree(tf_den))
+        D = tf_num(0) / tf_den(0);
+
+    A.topRightCorner(order-1, order-1) = Eigen::MatrixXd::Identity(order-1, order-1);
+    for (unsigned int i = 0; i < order; i++)
+        A(order-1,i) = -tf_den(order-i);
+
+    B(order-1) = 1;
+
+    for (unsigned int i = 0; i < order; i++)
+        C(i) = tf_num(order-i) - D * tf_den(order-i);
+}
+
+void DiscreteRealization::update(FilterState &fstate, const Input &signalIn) const
+{
+    output(fstate, signalIn);
+    advance(fstate, signalIn);
+}
+
+void DiscreteRealization::output(FilterState &fstate, const Input &signalIn) const
+{
+    fstate.last_output.noalias() = fstate.state * C.transpose();
+    fstate.last_output += D * signalIn.transpose();
+}
+
+void DiscreteRealization::advance(FilterState &fstate, const Input &signalIn) const
+{
+    // Per-thread scratch for the next state; it only grows, so steady-state updates
+    // don't allocate even when filters of different sizes share a thread
+    static thread_local Eigen::VectorXd scratch;
+    Eigen::Index size = fstate.state.size();
+    if (scratch.size() < size)
+        scratch.resize(size);
+
+    if (form == MODAL)
+    {
+        // Each mode only depends on itself: O(N) per filter instead of O(N^2)
+        Eigen::Map<Eigen::VectorXd> previous(scratch.data(), fstate.state.rows());
+        for (unsigned int i = 0, k = 0; k < mode_sizes.size(); i += mode_sizes[k++])
+        {
+            if (mode_sizes[k] == 1)
+                fstate.state.col(i) = A(i, i) * fstate.state.col(i) + B(i) * signalIn.transpose();
+            else
+            {
+                previous = fstate.state.col(i);
+                fstate.state.col(i) = A(i, i) * previous + A(i, i+1) * fstate.state.col(i+1) + B(i) * signalIn.transpose();
+                fstate.state.col(i+1) = A(i+1, i) * previous + A(i+1, i+1) * fstate.state.col(i+1) + B(i+1) * signalIn.transpose();
+            }
+        }
+        return;
+    }
+
+    Eigen::Map<Eigen::MatrixXd> next_state(scratch.data(), fstate.state.rows(), fstate.state.cols());
+
+    next_state.noalias() = fstate.state * A.transpose();
+    next_state.noalias() += signalIn.transpose() * B.transpose();
+    fstate.state = next_state;
+}
+
+void DiscreteRealization::setInitialState(FilterState &fstate, const Eigen::MatrixXd &u_history,
+    const Eigen::MatrixXd &initial_output_derivatives) const
+{
+    unsigned int n_filters = fstate.state.rows();
+
+    if (initial_output_derivatives.cols() != order)
+    {
+        char buffer[70];
+        std::sprintf(buffer, "expected %d %s per row, but received %d",
+                     order,
+                     (order == 1) ? "element" : "elements",
+                     (int) initial_output_derivatives.cols());
+        throw std::logic_error(buffer);
+    }
+
+    if (initial_output_derivatives.rows() != n_filters)
+    {
+        char buffer[70];
+        std::sprintf(buffer, "expected %d %s per column, but received %d",
+                     n_filters,
+                     (n_filters == 1) ? "element" : "elements",
+                     (int) initial_output_derivatives.rows());
+        throw std::logic_error(buffer);
+    }
+
+    if (u_history.cols() != order)
+    {
+        char buffer[70];
+        std::sprintf(buffer, "expected %d input %s per row, but received %d",
+                     order,
+                     (order == 1) ? "entry" : "entries",
+                     (int) u_history.cols());
+        throw std::logic_error(buffer);
+    }
+
+    if (u_history.rows() != n_filters)
+    {
+        throw std::logic_error("the number of input channels is different from the number of filters");
+    }
+
+    if (order == 0)
+    {
+        return;
+    }
+
+    Eigen::MatrixXd Cbar(order,order);
+    Eigen::MatrixXd Dbar(order,order);
+    Eigen::VectorXd y(order);
+    Eigen::RowVectorXd tmp(order);
+    double acc;
+
+    // Compute initial condition for each filter
+    for (unsigned int i = 0; i < n_filters; i++)
+    {
+        Cbar.setZero();
+        Cbar.row(0) = C;
+        Dbar.setZero();
+        y.setZero();
+        y(0) = initial_output_derivatives(i,0);
+
+        for (unsigned int j = 1; j < order; j++)
+        {
+            // equivalent to tmp = Cbar(j-1,:) / A
+            tmp = A.transpose().colPivHouseholderQr().solve(Cbar.row(j-1).transpose()).transpose();
+            Cbar.row(j) = tmp;
+            Dbar(j,1) = tmp * B;
+
+            if (j > 1)
+                Dbar.block(j,2,1,j-1) = Dbar.block(j-1,1,1,j-1);
+
+            acc = 0;
+            for (unsigned int k = 0; k <= j-1; k++)
+                acc += NchooseK(j,k) * std::pow(-1,k) * y(k);
+
+            y(j) = (std::pow(Ts,j) * initial_output_derivatives(i,j) - acc) * std::pow(-1,j);
+        }
+        Dbar -= D*Eigen::MatrixXd::Identity(order,order);
+        fstate.state.row(i) = Cbar.colPivHouseholderQr().solve(Dbar * u_history.row(i).transpose() + y);
+    }
+
+    // Reset initial output
+    fstate.last_output = initial_output_derivatives.col(0);
+}
+
+Eigen::VectorXd DiscreteRealization::unitSteadyState() const
+{
+    if (order == 0)
+        return Eigen::VectorXd();
+
+    Eigen::FullPivLU<Eigen::MatrixXd> lu(Eigen::MatrixXd::Identity(order, order) - A);
+    if (!lu.isInvertible())
+        throw std::logic_error("the filter has a pole at z = 1, so it has no steady state");
+    return lu.solve(B);
+}
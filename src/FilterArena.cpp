@@ -0,0 +1,30 @@
+#include "FilterArena.hpp"
+#include <new>
+#include <stdint.h>
+
+using namespace linear_system;
+
+FilterArena::FilterArena(std::size_t capacity) :
+    block(new char[capacity + alignment]), capacity(capacity), used(0)
+{
+    uintptr_t address = reinterpret_cast<uintptr_t>(block);
+    begin = block + (alignment - address % alignment) % alignment;
+}
+
+FilterArena::~FilterArena()
+{
+    delete[] block;
+}
+
+double * FilterArena::allocate(std::size_t n)
+{
+    std::size_t bytes = (n * sizeof(double) + alignment - 1) / alignment * alignment;
+    std::size_t offset = used.load();
+    do
+    {
+        if (bytes > capacity - offset)
+            throw std::bad_alloc();
+    }
+    while (!used.compare_exchange_weak(offset, offset + bytes));
+    return reinterpret_cast<double *>(begin + offset);
+}
@@ -0,0 +1,96 @@
+#include "FilterBank.hpp"
+#include <stdexcept>
+
+using namespace linear_system;
+
+template<typename State, typename Accumulator>
+FilterBank<State, Accumulator>::FilterBank(std::shared_ptr<const DiscreteRealization> realization, unsigned int n_filters) :
+    FilterBank(std::move(realization), n_filters, nullptr)
+{
+}
+
+template<typename State, typename Accumulator>
+FilterBank<State, Accumulator>::FilterBank(std::shared_ptr<const DiscreteRealization> realization, unsigned int n_filters,
+    FilterArena &arena) :
+    FilterBank(std::move(realization), n_filters, &arena)
+{
+}
+
+template<typename State, typename Accumulator>
+FilterBank<State, Accumulator>::FilterBank(std::shared_ptr<const DiscreteRealization> realization, unsigned int n_filters,
+    FilterArena *arena) :
+    realization(std::move(realization)), state(arena), next(arena)
+{
+    if (!this->realization)
+        throw std::logic_error("received an empty realization");
+    if (n_filters == 0)
+        throw std::logic_error("received n_filters = 0, but FilterBank must implement at least one filter");
+
+    const DiscreteRealization &r = *this->realization;
+    const unsigned int order = r.getOrder();
+    a_entries = nonzeroEntries<Accumulator>(r.getA());
+    for (unsigned int i = 0; i < order; ++i)
+    {
+        B.push_back(static_cast<Accumulator>(r.getB()(i)));
+        C.push_back(static_cast<Accumulator>(r.getC()(i)));
+    }
+    D = static_cast<Accumulator>(r.getD());
+
+    state.resize(n_filters, order);
+    state.matrix().setZero();
+    next.resize(n_filters, order);
+    input_acc.resize(n_filters);
+    output_acc.resize(n_filters);
+}
+
+template<typename State, typename Accumulator>
+void FilterBank<State, Accumulator>::update(const Eigen::Ref<const Vector> &input, Eigen::Ref<Vector> output)
+{
+    Eigen::Map<Matrix> &x = state.matrix();
+    Eigen::Map<typename ArenaMatrix<Accumulator>::Matrix> &next_x = next.matrix();
+    if (input.size() != x.rows() || output.size() != x.rows())
+        throw std::logic_error("the number of inputs and outputs must match the number of filters");
+    LINEAR_SYSTEM_PERF_SCOPE(profile.get(), PERF_UPDATE);
+
+    const unsigned int order = x.cols();
+    input_acc = input.template cast<Accumulator>();
+
+    // y = Cx + Du
+    output_acc = D * input_acc;
+    for (unsigned int j = 0; j < order; ++j)
+        output_acc += C[j] * x.col(j).template cast<Accumulator>();
+    output = output_acc.template cast<State>();
+
+    // x = Ax + Bu
+    for (unsigned int i = 0; i < order; ++i)
+        next_x.col(i) = B[i] * input_acc;
+    for (const MatrixEntry<Accumulator> &e : a_entries)
+        next_x.col(e.row) += e.value * x.col(e.col).template cast<Accumulator>();
+    x = next_x.template cast<State>();
+}
+
+template<typename State, typename Accumulator>
+void FilterBank<State, Accumulator>::process(const Matrix &input, Matrix &output)
+{
+    if (input.rows() != state.matrix().rows())
+        throw std::logic_error("the number of input channels is different from the number of filters");
+
+    output.resize(input.rows(), input.cols());
+    for (Eigen::Index k = 0; k < input.cols(); ++k)
+        update(input.col(k), output.col(k));
+}
+
+template<typename State, typename Accumulator>
+void FilterBank<State, Accumulator>::setState(const Matrix &state)
+{
+    if (state.rows() != this->state.matrix().rows() || state.cols() != this->state.matrix().cols())
+        throw std::logic_error("the state must have one row per filter and one column per state");
+    this->state.matrix() = state;
+}
+
+namespace linear_system
+{
+template class FilterBank<double>;
+template class FilterBank<float>;
+template class FilterBank<float, double>;
+}
@@ -0,0 +1,97 @@
+#include "FilterState.hpp"
+#include "FilterArena.hpp"
+#include <new>
+
+using namespace linear_system;
+
+std::size_t FilterState::storageSize(Eigen::Index n_filters, Eigen::Index order)
+{
+    // The outputs start on their own cache line
+    std::size_t line = FilterArena::alignment / sizeof(double);
+    std::size_t state_size = (n_filters * order + line - 1) / line * line;
+    return state_size + n_filters;
+}
+
+void FilterState::remap(double *data, Eigen::Index n_filters, Eigen::Index order)
+{
+    new (&state) Eigen::Map<Eigen::MatrixXd>(data, n_filters, order);
+    new (&last_output) Eigen::Map<Output>(data + storageSize(n_filters, order) - n_filters, n_filters);
+}
+
+FilterState::FilterState(FilterArena *arena) :
+    state(nullptr, 0, 0), last_output(nullptr, 0), time(0), arena(arena), capacity(0)
+{
+}
+
+FilterState::FilterState(const FilterState &other) :
+    state(nullptr, 0, 0), last_output(nullptr, 0), time(0), arena(nullptr), capacity(0)
+{
+    *this = other;
+}
+
+FilterState::FilterState(FilterState &&other) noexcept :
+    state(nullptr, 0, 0), last_output(nullptr, 0), time(other.time),
+    heap_storage(std::move(other.heap_storage)), arena(other.arena), capacity(other.capacity)
+{
+    remap(other.state.data(), other.state.rows(), other.state.cols());
+    other.remap(nullptr, 0, 0);
+    other.capacity = 0;
+}
+
+FilterState & FilterState::operator=(const FilterState &other)
+{
+    if (this == &other)
+        return *this;
+
+    if (state.rows() != other.state.rows() || state.cols() != other.state.cols())
+        reset(other.state.rows(), other.state.cols());
+
+    state = other.state;
+    last_output = other.last_output;
+    time = other.time;
+    return *this;
+}
+
+FilterState & FilterState::operator=(FilterState &&other)
+{
+    if (this == &other)
+        return *this;
+
+    // Storage can only be taken over when both states draw it from the same place
+    if (arena != other.arena)
+        return *this = static_cast<const FilterState &>(other);
+
+    heap_storage.swap(other.heap_storage);
+    std::swap(capacity, other.capacity);
+    double *data = state.data();
+    Eigen::Index rows = state.rows(), cols = state.cols();
+    remap(other.state.data(), other.state.rows(), other.state.cols());
+    other.remap(data, rows, cols);
+    time = other.time;
+    return *this;
+}
+
+void FilterState::reset(unsigned int n_filters, unsigned int order)
+{
+    std::size_t size = storageSize(n_filters, order);
+    double *data = state.data();
+    if (size > capacity)
+    {
+        if (arena)
+        {
+            // The arena hands out whole cache lines, so make use of the padding as well
+            std::size_t line = FilterArena::alignment / sizeof(double);
+            size = (size + line - 1) / line * line;
+            data = arena->allocate(size);
+        }
+        else
+        {
+            heap_storage.resize(size);
+            data = heap_storage.data();
+        }
+        capacity = size;
+    }
+    remap(data, n_filters, order);
+    state.setZero();
+    last_output.setZero();
+}
@@ -0,0 +1,169 @@
+#include "FixedPoint.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace linear_system;
+
+namespace
+{
+
+// Impulse responses are summed until their tail is negligible, up to this many samples
+const unsigned int max_impulse_length = 1000000;
+
+inline int32_t saturate(int64_t value)
+{
+    if (value > std::numeric_limits<int32_t>::max())
+        return std::numeric_limits<int32_t>::max();
+    if (value < std::numeric_limits<int32_t>::min())
+        return std::numeric_limits<int32_t>::min();
+    return static_cast<int32_t>(value);
+}
+
+inline int32_t roundShift(int64_t acc, unsigned int shift)
+{
+    if (shift == 0)
+        return saturate(acc);
+    return saturate((acc + (int64_t(1) << (shift - 1))) >> shift);
+}
+
+/*
+ * Number of fractional bits leaving \p bits integer bits for \p magnitude, i.e. the largest
+ * f such that magnitude * 2^f < 2^bits.
+ */
+int fractionalBits(double magnitude, int bits)
+{
+    return bits - (int) std::floor(std::log2(magnitude)) - 1;
+}
+
+}
+
+FixedPointRealization::FixedPointRealization(const DiscreteRealization &realization, double input_range) :
+    order(realization.getOrder()), Ts(realization.getSampling())
+{
+    if (!(input_range > 0))
+        throw std::logic_error("the input range must be positive");
+
+    const unsigned int n = order;
+    Eigen::MatrixXd A = realization.getA();
+    Eigen::VectorXd B = realization.getB();
+    Eigen::RowVectorXd C = realization.getC();
+    double D = realization.getD();
+
+    // L1 norms of the impulse responses from the input to each state and to the output,
+    // which only converge for stable filters
+    Eigen::VectorXd state_bound = Eigen::VectorXd::Zero(n);
+    double output_bound = std::abs(D);
+    Eigen::VectorXd v = B, next(n);
+    bool converged = (n == 0);
+    for (unsigned int k = 0; k < max_impulse_length && !converged; ++k)
+    {
+        double norm = v.lpNorm<1>();
+        if (!std::isfinite(norm))
+            break;
+        state_bound += v.cwiseAbs();
+        output_bound += std::abs(C.dot(v));
+        converged = (norm <= 1e-16 * state_bound.sum());
+        next.noalias() = A * v;
+        v.swap(next);
+    }
+    if (!converged)
+        throw std::logic_error("only stable filters can be converted to fixed point");
+
+    // Power of two scaling bringing every state bound to at most 1
+    Eigen::VectorXd scale = Eigen::VectorXd::Ones(n);
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        if (state_bound(i) > 0)
+            scale(i) = std::ldexp(1.0, -(int) std::ceil(std::log2(state_bound(i))));
+    }
+    Eigen::MatrixXd stacked(n + 1, n + 1);
+    stacked.topLeftCorner(n, n) = scale.asDiagonal() * A * scale.cwiseInverse().asDiagonal();
+    stacked.topRightCorner(n, 1) = scale.cwiseProduct(B);
+    stacked.bottomLeftCorner(1, n) = C * scale.cwiseInverse().asDiagonal();
+    stacked(n, n) = D;
+
+    // One guard bit on the signals, and room in the int64 accumulator for the n+1 products
+    signal_bits = fractionalBits(input_range, 30);
+    output_bits = (output_bound > 0) ? fractionalBits(output_bound * input_range, 30) : signal_bits;
+    const int coefficient_integer_bits = 30 - std::max(0, (int) std::ceil(std::log2(n + 1.0)) - 1);
+
+    coefficients.resize((n + 1) * (n + 1));
+    shifts.resize(n + 1);
+    for (unsigned int r = 0; r <= n; ++r)
+    {
+        double largest = stacked.row(r).cwiseAbs().maxCoeff();
+        int bits = (largest > 0) ? fractionalBits(largest, coefficient_integer_bits) : 0;
+        if (bits < 0)
+            throw std::logic_error("the filter coefficients are too large for fixed point");
+
+        // The accumulator holds Q(signal_bits + bits); the result is in the signal or output format
+        bits = std::min(bits, 62);
+        if (r == n)
+        {
+            output_bits = std::min(output_bits, signal_bits + bits);
+            bits = std::min(bits, 62 + output_bits - signal_bits);
+            shifts[r] = signal_bits + bits - output_bits;
+        }
+        else
+            shifts[r] = bits;
+
+        for (unsigned int j = 0; j <= n; ++j)
+            coefficients[r * (n + 1) + j] = (int32_t) std::llround(std::ldexp(stacked(r, j), bits));
+    }
+}
+
+int32_t FixedPointRealization::update(int32_t *state, int32_t *scratch, int32_t input) const
+{
+    const unsigned int n = order, width = n + 1;
+
+    // y = Cx + Du, from the current state
+    const int32_t *row = coefficients.data() + n * width;
+    int64_t acc = int64_t(row[n]) * input;
+    for (unsigned int j = 0; j < n; ++j)
+        acc += int64_t(row[j]) * state[j];
+    int32_t output = roundShift(acc, shifts[n]);
+
+    // x = Ax + Bu
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        row = coefficients.data() + i * width;
+        acc = int64_t(row[n]) * input;
+        for (unsigned int j = 0; j < n; ++j)
+            acc += int64_t(row[j]) * state[j];
+        scratch[i] = roundShift(acc, shifts[i]);
+    }
+    std::copy(scratch, scratch + n, state);
+    return output;
+}
+
+int32_t FixedPointRealization::quantizeInput(double input) const
+{
+    double value = std::ldexp(input, signal_bits);
+    if (!(value > std::numeric_limits<int32_t>::min()))
+        return std::numeric_limits<int32_t>::min();
+    if (value >= std::numeric_limits<int32_t>::max())
+        return std::numeric_limits<int32_t>::max();
+    return (int32_t) std::lround(value);
+}
+
+double FixedPointRealization::outputToDouble(int32_t output) const
+{
+    return std::ldexp((double) output, -output_bits);
+}
+
+FixedPointFilter::FixedPointFilter(std::shared_ptr<const FixedPointRealization> realization) :
+    realization(std::move(realization))
+{
+    if (!this->realization)
+        throw std::logic_error("received an empty realization");
+
+    state.assign(this->realization->getOrder(), 0);
+    scratch.assign(this->realization->getOrder(), 0);
+}
+
+void FixedPointFilter::reset()
+{
+    std::fill(state.begin(), state.end(), 0);
+}
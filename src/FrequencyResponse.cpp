@@ -0,0 +1,136 @@
+#include "FrequencyResponse.hpp"
+#include "Parallel.hpp"
+#include <stdexcept>
+
+using namespace linear_system;
+
+namespace
+{
+
+// Frequencies are processed in chunks small enough to stay in L1 and be stored on the stack
+const Eigen::Index chunk_size = 256;
+typedef Eigen::Array<double, Eigen::Dynamic, 1, 0, chunk_size, 1> Chunk;
+
+/*
+ * Horner evaluation of poly at every z = zr + j zi, with real and imaginary parts kept
+ * in separate arrays so that the recurrence vectorizes across frequencies.
+ */
+void horner(const Poly &poly, const Chunk &zr, const Chunk &zi, Chunk &re, Chunk &im)
+{
+    re.setConstant(poly(0));
+    im.setZero();
+    Chunk tmp(zr.size());
+    for (Eigen::Index k = 1; k < poly.size(); ++k)
+    {
+        tmp = re * zr - im * zi + poly(k);
+        im = re * zi + im * zr;
+        re = tmp;
+    }
+}
+
+/*
+ * Writes num(z)/den(z) into out[begin, end), where z = jw (continuous-time) or
+ * z = e^{jwTs} (discrete-time).
+ */
+void evaluate(const Poly &num, const Poly &den, bool discrete, double ts, const Eigen::VectorXd &omega,
+    Eigen::Ref<Eigen::VectorXcd> out, Eigen::Index begin, Eigen::Index end)
+{
+    for (Eigen::Index start = begin; start < end; start += chunk_size)
+    {
+        Eigen::Index n = std::min(chunk_size, end - start);
+        Chunk zr(n), zi(n), nr(n), ni(n), dr(n), di(n), mag(n);
+        if (discrete)
+        {
+            zr = (omega.segment(start, n).array() * ts).cos();
+            zi = (omega.segment(start, n).array() * ts).sin();
+        }
+        else
+        {
+            zr.setZero();
+            zi = omega.segment(start, n).array();
+        }
+        horner(num, zr, zi, nr, ni);
+        horner(den, zr, zi, dr, di);
+
+        mag = dr.square() + di.square();
+        out.segment(start, n).real() = (nr * dr + ni * di) / mag;
+        out.segment(start, n).imag() = (ni * dr - nr * di) / mag;
+    }
+}
+
+Eigen::MatrixXcd response(const std::vector<std::shared_ptr<const DiscreteRealization> > &realizations,
+    const Eigen::VectorXd &omega, bool discrete, unsigned int n_threads)
+{
+    Eigen::MatrixXcd ret(omega.size(), realizations.size());
+    long n_filters = realizations.size();
+    // Long grids are split across threads; many filters over short grids are split by filter
+    if (n_filters > 1 && omega.size() < n_filters * chunk_size)
+    {
+        parallelFor(n_filters, n_threads, [&](long begin, long end) {
+            for (long i = begin; i < end; ++i)
+            {
+                const DiscreteRealization &ss = *realizations[i];
+                evaluate(discrete ? ss.getNumerator() : ss.getContinuousNumerator(),
+                         discrete ? ss.getDenominator() : ss.getContinuousDenominator(),
+                         discrete, ss.getSampling(), omega, ret.col(i), 0, omega.size());
+            }
+        });
+    }
+    else
+    {
+        for (long i = 0; i < n_filters; ++i)
+        {
+            const DiscreteRealization &ss = *realizations[i];
+            parallelFor(omega.size(), n_threads, [&](long begin, long end) {
+                evaluate(discrete ? ss.getNumerator() : ss.getContinuousNumerator(),
+                         discrete ? ss.getDenominator() : ss.getContinuousDenominator(),
+                         discrete, ss.getSampling(), omega, ret.col(i), begin, end);
+            });
+        }
+    }
+    return ret;
+}
+
+}
+
+Eigen::VectorXcd linear_system::continuousResponse(const DiscreteRealization &realization, const Eigen::VectorXd &omega,
+    unsigned int n_threads)
+{
+    if (!realization.hasContinuousModel())
+        throw std::logic_error("the filter was designed in discrete time and has no continuous-time response");
+
+    Eigen::VectorXcd ret(omega.size());
+    parallelFor(omega.size(), n_threads, [&](long begin, long end) {
+        evaluate(realization.getContinuousNumerator(), realization.getContinuousDenominator(), false,
+                 realization.getSampling(), omega, ret, begin, end);
+    });
+    return ret;
+}
+
+Eigen::VectorXcd linear_system::discreteResponse(const DiscreteRealization &realization, const Eigen::VectorXd &omega,
+    unsigned int n_threads)
+{
+    Eigen::VectorXcd ret(omega.size());
+    parallelFor(omega.size(), n_threads, [&](long begin, long end) {
+        evaluate(realization.getNumerator(), realization.getDenominator(), true,
+                 realization.getSampling(), omega, ret, begin, end);
+    });
+    return ret;
+}
+
+Eigen::MatrixXcd linear_system::continuousResponse(const std::vector<std::shared_ptr<const DiscreteRealization> > &realizations,
+    const Eigen::VectorXd &omega, unsigned int n_threads)
+{
+    for (std::size_t i = 0; i < realizations.size(); ++i)
+    {
+        if (!realizations[i]->hasContinuousModel())
+            throw std::logic_error("the filter was designed in discrete time and has no continuous-time response");
+    }
+    return response(realizations, omega, false, n_threads);
+}
+
+Eigen::MatrixXcd linear_system::discreteResponse(const std::vector<std::shared_ptr<const DiscreteRealization> > &realizations,
+    const Eigen::VectorXd &omega, unsigned int n_threads)
+{
+    return response(realizations, omega, true, n_threads);
+}
@@ -1,5 +1,24 @@
 #include "HelperFunctions.hpp"
 
+namespace
+{
+
+// 2 pi in two parts (Cody and Waite): the high one has 26 significant bits, so that k * hi is
+// exact for the multiples k of any angle a double resolves to better than 1e-8
+const double two_pi_hi = 6.283185243606567;
+const double two_pi_lo = 6.357301909411278e-08;
+const double inv_two_pi = 0.15915494309189535;
+
+// Adding then subtracting 1.5 * 2^52 rounds |x| < 2^51 to the nearest integer, without a
+// branch or a library call
+const double round_magic = 6755399441055744.0;
+
+// Differences with pi are either 0 or at least an ulp of pi, 2^-51: scaled by this they
+// saturate to a 0/1 step, which avoids the comparisons that would keep the loops scalar
+const double step_scale = 1152921504606846976.0; // 2^60
+
+}
+
 unsigned int linear_system::NchooseK(unsigned int N, unsigned int K)
 {
     double ret = 1;
@@ -8,6 +27,58 @@ unsigned int linear_system::NchooseK(unsigned int N, unsigned int K)
     return (unsigned int)ret;
 }
 
+Eigen::MatrixXd linear_system::MatrixExponential(const Eigen::MatrixXd &M)
+{
+    static const double b[] = {64764752532480000., 32382376266240000., 7771770303897600.,
+        1187353796428800., 129060195264000., 10559470521600., 670442572800.,
+        33522128640., 1323241920., 40840800., 960960., 16380., 182., 1.};
+    static const double theta13 = 5.371920351148152;
+
+    const long n = M.rows();
+    const Eigen::MatrixXd I = Eigen::MatrixXd::Identity(n, n);
+    if (n == 0)
+        return I;
+
+    // Scale M so that its 1-norm is below theta13
+    double norm = M.cwiseAbs().colwise().sum().maxCoeff();
+    int s = (norm > theta13) ? (int) std::ceil(std::log2(norm / theta13)) : 0;
+    Eigen::MatrixXd A = M / std::pow(2.0, s);
+
+    Eigen::MatrixXd A2 = A * A;
+    Eigen::MatrixXd A4 = A2 * A2;
+    Eigen::MatrixXd A6 = A4 * A2;
+
+    Eigen::MatrixXd U = A * (A6 * (b[13]*A6 + b[11]*A4 + b[9]*A2) + b[7]*A6 + b[5]*A4 + b[3]*A2 + b[1]*I);
+    Eigen::MatrixXd V = A6 * (b[12]*A6 + b[10]*A4 + b[8]*A2) + b[6]*A6 + b[4]*A4 + b[2]*A2 + b[0]*I;
+
+    Eigen::MatrixXd R = (V - U).partialPivLu().solve(V + U);
+    for (int k = 0; k < s; ++k)
+        R = R * R;
+    return R;
+}
+
+Eigen::VectorXd linear_system::CharacteristicPolynomial(const Eigen::MatrixXd &M)
+{
+    const long n = M.rows();
+    Eigen::VectorXcd poly = Eigen::VectorXcd::Zero(n + 1);
+    poly(0) = 1;
+    if (n == 0)
+        return poly.real();
+
+    Eigen::VectorXcd roots = M.eigenvalues();
+    for (long i = 0; i < n; ++i)
+    {
+        for (long k = i + 1; k > 0; --k)
+            poly(k) -= roots(i) * poly(k-1);
+    }
+    return poly.real();
+}
+
+Eigen::VectorXcd linear_system::PolynomialRoots(const Eigen::VectorXd &poly)
+{
+    return polynomial::roots(poly);
+}
+
 void linear_system::wrap2pi(double & ang)
 {
     ang = std::fmod(ang,2*M_PI);
@@ -19,8 +90,21 @@ void linear_system::wrap2pi(double & ang)
 
 void linear_system::wrap2pi(Eigen::VectorXd &ang)
 {
-    for (unsigned int i = 0; i < ang.size(); ++i)
-        wrap2pi(ang(i));
+    wrap2pi(Eigen::Ref<Eigen::MatrixXd>(ang));
+}
+
+void linear_system::wrap2pi(Eigen::Ref<Eigen::MatrixXd> ang)
+{
+    for (Eigen::Index j = 0; j < ang.cols(); ++j)
+    {
+        Eigen::Map<Eigen::ArrayXd> a(ang.col(j).data(), ang.rows());
+        // a - 2 pi k with k the nearest integer to a / 2 pi, which lands in [-pi, pi] up to
+        // an ulp; then the ends are moved to (-pi, pi]
+        a = (a - ((a * inv_two_pi + round_magic) - round_magic) * two_pi_hi)
+            - ((a * inv_two_pi + round_magic) - round_magic) * two_pi_lo;
+        a = a - 2 * M_PI * ((a - M_PI) * step_scale).max(0.0).min(1.0)
+            + 2 * M_PI * ((-M_PI - a) * step_scale + 1).max(0.0).min(1.0);
+    }
 }
 
 double linear_system::resonant2cutoff(double w, double damp)
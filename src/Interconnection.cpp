@@ -0,0 +1,169 @@
+#include "Interconnection.hpp"
+#include <cmath>
+#include <stdexcept>
+
+using namespace linear_system;
+
+namespace
+{
+
+typedef std::shared_ptr<const DiscreteRealization> Realization;
+
+double commonSampling(const Realization &first, const Realization &second)
+{
+    if (!first || !second)
+        throw std::logic_error("received an empty realization");
+    double ts = first->getSampling();
+    if (std::abs(ts - second->getSampling()) > 1e-12 * ts)
+        throw std::logic_error("only filters with the same sampling period can be interconnected");
+    return ts;
+}
+
+/*
+ * Orthonormal basis of the Krylov space span(b, Ab, A^2 b, ...), by Arnoldi iterations with
+ * a second Gram-Schmidt pass, as the columns of the returned matrix.
+ */
+Eigen::MatrixXd krylovBasis(const Eigen::MatrixXd &A, const Eigen::VectorXd &b, double tolerance)
+{
+    const Eigen::Index n = A.rows();
+    Eigen::MatrixXd V(n, n);
+    double norm = b.norm();
+    if (n == 0 || norm == 0)
+        return V.leftCols(0);
+
+    const double threshold = tolerance * A.norm();
+    V.col(0) = b / norm;
+    Eigen::Index rank = 1;
+    Eigen::VectorXd w(n);
+    for (; rank < n; ++rank)
+    {
+        w = A * V.col(rank - 1);
+        for (int pass = 0; pass < 2; ++pass)
+            w -= V.leftCols(rank) * (V.leftCols(rank).transpose() * w);
+        norm = w.norm();
+        if (norm <= threshold)
+            break;
+        V.col(rank) = w / norm;
+    }
+    return V.leftCols(rank);
+}
+
+}
+
+Realization linear_system::series(const Realization &first, const Realization &second)
+{
+    double ts = commonSampling(first, second);
+    const Eigen::Index n1 = first->getOrder(), n2 = second->getOrder();
+
+    // x1' = A1 x1 + B1 u, x2' = A2 x2 + B2 (C1 x1 + D1 u), y = C2 x2 + D2 (C1 x1 + D1 u)
+    Eigen::MatrixXd A = Eigen::MatrixXd::Zero(n1 + n2, n1 + n2);
+    A.topLeftCorner(n1, n1) = first->getA();
+    A.bottomLeftCorner(n2, n1) = second->getB() * first->getC();
+    A.bottomRightCorner(n2, n2) = second->getA();
+    Eigen::VectorXd B(n1 + n2);
+    B << first->getB(), second->getB() * first->getD();
+    Eigen::RowVectorXd C(n1 + n2);
+    C << second->getD() * first->getC(), second->getC();
+    return std::make_shared<const DiscreteRealization>(A, B, C, second->getD() * first->getD(), ts);
+}
+
+Realization linear_system::parallel(const Realization &first, const Realization &second, double sign)
+{
+    double ts = commonSampling(first, second);
+    const Eigen::Index n1 = first->getOrder(), n2 = second->getOrder();
+
+    Eigen::MatrixXd A = Eigen::MatrixXd::Zero(n1 + n2, n1 + n2);
+    A.topLeftCorner(n1, n1) = first->getA();
+    A.bottomRightCorner(n2, n2) = second->getA();
+    Eigen::VectorXd B(n1 + n2);
+    B << first->getB(), second->getB();
+    Eigen::RowVectorXd C(n1 + n2);
+    C << first->getC(), sign * second->getC();
+    return std::make_shared<const DiscreteRealization>(A, B, C, first->getD() + sign * second->getD(), ts);
+}
+
+Realization linear_system::feedback(const Realization &forward, const Realization &backward, double sign)
+{
+    double ts = commonSampling(forward, backward);
+    const Eigen::Index n1 = forward->getOrder(), n2 = backward->getOrder();
+    const double D1 = forward->getD(), D2 = backward->getD();
+
+    // The loop is algebraic through the feedthroughs: with e = r + sign y2 the input of the
+    // forward filter, y = C1 x1 + D1 e and y2 = C2 x2 + D2 y give y = k (C1 x1 + sign D1 C2 x2 + D1 r)
+    const double loop = 1 - sign * D1 * D2;
+    if (loop == 0)
+        throw std::logic_error("the feedback loop is singular, since 1 - sign D_forward D_backward = 0");
+    const double k = 1 / loop;
+
+    Eigen::RowVectorXd C(n1 + n2);
+    C << k * forward->getC(), k * sign * D1 * backward->getC();
+    const double D = k * D1;
+
+    // e = Ce x + De r
+    Eigen::RowVectorXd Ce = sign * D2 * C;
+    Ce.tail(n2) += sign * backward->getC();
+    const double De = 1 + sign * D2 * D;
+
+    Eigen::MatrixXd A(n1 + n2, n1 + n2);
+    A.topRows(n1) = forward->getB() * Ce;
+    A.topLeftCorner(n1, n1) += forward->getA();
+    A.bottomRows(n2) = backward->getB() * C;
+    A.bottomRightCorner(n2, n2) += backward->getA();
+    Eigen::VectorXd B(n1 + n2);
+    B << De * forward->getB(), D * backward->getB();
+    return std::make_shared<const DiscreteRealization>(A, B, C, D, ts);
+}
+
+Realization linear_system::minimalRealization(const Realization &realization, double tolerance)
+{
+    if (!realization)
+        throw std::logic_error("received an empty realization");
+
+    // Restrict to the reachable subspace, then to the observable subspace of what is left
+    const Eigen::MatrixXd &A = realization->getA();
+    Eigen::MatrixXd V = krylovBasis(A, realization->getB(), tolerance);
+    Eigen::MatrixXd Ar = V.transpose() * A * V;
+    Eigen::VectorXd Br = V.transpose() * realization->getB();
+    Eigen::RowVectorXd Cr = realization->getC() * V;
+
+    Eigen::MatrixXd W = krylovBasis(Ar.transpose(), Cr.transpose(), tolerance);
+    Eigen::MatrixXd Am = W.transpose() * Ar * W;
+    Eigen::VectorXd Bm = W.transpose() * Br;
+    Eigen::RowVectorXd Cm = Cr * W;
+    return std::make_shared<const DiscreteRealization>(Am, Bm, Cm, realization->getD(), realization->getSampling());
+}
+
+LinearSystem linear_system::series(const LinearSystem &first, const LinearSystem &second)
+{
+    return LinearSystem(series(first.getRealization(), second.getRealization()));
+}
+
+LinearSystem linear_system::parallel(const LinearSystem &first, const LinearSystem &second, double sign)
+{
+    return LinearSystem(parallel(first.getRealization(), second.getRealization(), sign));
+}
+
+LinearSystem linear_system::feedback(const LinearSystem &forward, const LinearSystem &backward, double sign)
+{
+    return LinearSystem(feedback(forward.getRealization(), backward.getRealization(), sign));
+}
+
+LinearSystem linear_system::minimalRealization(const LinearSystem &system, double tolerance)
+{
+    return LinearSystem(minimalRealization(system.getRealization(), tolerance));
+}
+
+LinearSystem linear_system::operator*(const LinearSystem &second, const LinearSystem &first)
+{
+    return series(first, second);
+}
+
+LinearSystem linear_system::operator+(const LinearSystem &first, const LinearSystem &second)
+{
+    return parallel(first, second);
+}
+
+LinearSystem linear_system::operator-(const LinearSystem &first, const LinearSystem &second)
+{
+    return parallel(first, second, -1);
+}
@@ -0,0 +1,154 @@
+#include "MIMORealization.hpp"
+#include "HelperFunctions.hpp"
+#include <cmath>
+#include <stdexcept>
+
+using namespace linear_system;
+
+MIMORealization::MIMORealization(const Eigen::MatrixXd &A, const Eigen::MatrixXd &B, const Eigen::MatrixXd &C,
+    const Eigen::MatrixXd &D, double ts, IntegrationMethod method, double prewarp) :
+    Ts(ts), integration_method(method), prewarp_frequency(prewarp)
+{
+    if (A.rows() != A.cols())
+        throw std::logic_error("the state matrix must be square");
+    if (B.rows() != A.rows() || C.cols() != A.rows())
+        throw std::logic_error("the input and output matrices must have as many rows/columns as states");
+    if (D.rows() != C.rows() || D.cols() != B.cols())
+        throw std::logic_error("the feedthrough matrix must be (outputs by inputs)");
+    if (ts <= 0.0)
+        throw std::logic_error("non positive sampling time given");
+    if (prewarp < 0)
+        throw std::invalid_argument("prewarp frequency must be nonnegative");
+    if (integration_method != TUSTIN)
+        prewarp_frequency = 0;
+
+    discretize(A, B, C, D, Ts, integration_method, prewarp_frequency, this->A, this->B, this->C, this->D);
+
+    const unsigned int n = A.rows(), m = B.cols(), p = C.rows();
+    stacked.resize(n + p, n + m);
+    stacked << this->A, this->B,
+               this->C, this->D;
+}
+
+void MIMORealization::discretize(const Eigen::MatrixXd &A, const Eigen::MatrixXd &B, const Eigen::MatrixXd &C,
+    const Eigen::MatrixXd &D, double ts, IntegrationMethod method, double prewarp,
+    Eigen::MatrixXd &Ad, Eigen::MatrixXd &Bd, Eigen::MatrixXd &Cd, Eigen::MatrixXd &Dd)
+{
+    const unsigned int n = A.rows(), m = B.cols();
+    const Eigen::MatrixXd I = Eigen::MatrixXd::Identity(n, n);
+
+    switch(method)
+    {
+    case DIRECT:
+        Ad = A;
+        Bd = B;
+        Cd = C;
+        Dd = D;
+        break;
+    case FORWARD_EULER:
+        // s = (z - 1) / Ts
+        Ad = I + ts * A;
+        Bd = ts * B;
+        Cd = C;
+        Dd = D;
+        break;
+    case BACKWARD_EULER:
+    {
+        // s = (z - 1) / (z Ts)
+        Eigen::MatrixXd E = (I - ts * A).partialPivLu().inverse();
+        Ad = E;
+        Bd = ts * E * B;
+        Cd = C * E;
+        Dd = D + C * Bd;
+        break;
+    }
+    case TUSTIN:
+    {
+        // s = a (z - 1) / (z + 1)
+        double a = (prewarp != 0) ? prewarp / tan(prewarp * ts / 2) : 2 / ts;
+        Eigen::MatrixXd E = (I - A / a).partialPivLu().inverse();
+        Ad = E * (I + A / a);
+        Bd = std::sqrt(2 / a) * E * B;
+        Cd = std::sqrt(2 / a) * C * E;
+        Dd = D + C * E * B / a;
+        break;
+    }
+    case ZOH:
+    {
+        // expm([A B; 0 0] Ts) = [Ad Bd; 0 I]
+        Eigen::MatrixXd M = Eigen::MatrixXd::Zero(n + m, n + m);
+        M.topLeftCorner(n, n) = A * ts;
+        M.topRightCorner(n, m) = B * ts;
+        Eigen::MatrixXd E = MatrixExponential(M);
+        Ad = E.topLeftCorner(n, n);
+        Bd = E.topRightCorner(n, m);
+        Cd = C;
+        Dd = D;
+        break;
+    }
+    case FOH:
+    {
+        // expm([A Ts, B Ts, 0; 0 0 I; 0 0 0]) = [Phi G1 G2; 0 I I; 0 0 I], and with the
+        // state x - G2 u the triangle hold becomes causal
+        Eigen::MatrixXd M = Eigen::MatrixXd::Zero(n + 2 * m, n + 2 * m);
+        M.topLeftCorner(n, n) = A * ts;
+        M.block(0, n, n, m) = B * ts;
+        M.block(n, n + m, m, m).setIdentity();
+        Eigen::MatrixXd E = MatrixExponential(M);
+        Ad = E.topLeftCorner(n, n);
+        Eigen::MatrixXd G1 = E.block(0, n, n, m);
+        Eigen::MatrixXd G2 = E.block(0, n + m, n, m);
+        Bd = G1 + Ad * G2 - G2;
+        Cd = C;
+        Dd = D + C * G2;
+        break;
+    }
+    case IMPULSE_INVARIANT:
+        if (D.size() > 0 && D.cwiseAbs().maxCoeff() > 0)
+            throw std::logic_error("impulse invariance requires a strictly proper filter");
+        Ad = MatrixExponential(A * ts);
+        Bd = ts * Ad * B;
+        Cd = C;
+        Dd = ts * C * B;
+        break;
+    default: throw std::logic_error("invalid integration method");
+    }
+}
+
+MIMOSystem::MIMOSystem(std::shared_ptr<const MIMORealization> realization) :
+    realization(std::move(realization))
+{
+    if (!this->realization)
+        throw std::logic_error("received an empty realization");
+
+    const unsigned int n = this->realization->getOrder();
+    state_input.setZero(n + this->realization->getNInputs());
+    state_output.setZero(n + this->realization->getNOutputs());
+}
+
+const Eigen::VectorXd::ConstSegmentReturnType MIMOSystem::update(const Eigen::Ref<const Eigen::VectorXd> &input)
+{
+    const unsigned int n = realization->getOrder(), m = realization->getNInputs();
+    if (input.size() != m)
+        throw std::logic_error("the number of inputs does not match the system");
+
+    state_input.tail(m) = input;
+    state_output.noalias() = realization->getStacked() * state_input;
+    state_input.head(n) = state_output.head(n);
+    return getOutput();
+}
+
+void MIMOSystem::process(const Eigen::MatrixXd &input, Eigen::MatrixXd &output)
+{
+    output.resize(realization->getNOutputs(), input.cols());
+    for (Eigen::Index k = 0; k < input.cols(); ++k)
+        output.col(k) = update(input.col(k));
+}
+
+void MIMOSystem::setState(const Eigen::Ref<const Eigen::VectorXd> &state)
+{
+    if (state.size() != realization->getOrder())
+        throw std::logic_error("the state size does not match the system order");
+
+    state_input.head(state.size()) = state;
+}
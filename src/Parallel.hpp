@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace linear_system
+{
+
+/*!
+ * \brief Returns \p n_threads, or the number of hardware threads if it is 0.
+ */
+inline unsigned int resolveThreads(unsigned int n_threads)
+{
+    if (n_threads == 0)
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    return n_threads;
+}
+
+/*!
+ * \brief Splits [0, \p n) into contiguous ranges and calls \p body(begin, end) for each one,
+ * using up to \p n_threads threads (0 selects the number of hardware threads).
+ *
+ * The calling thread processes the first range; it returns once every range is done. If
+ * \p body throws, the first exception is rethrown in the calling thread.
+ */
+template<typename Body>
+void parallelFor(long n, unsigned int n_threads, const Body &body)
+{
+    n_threads = std::min<long>(resolveThreads(n_threads), std::max(1L, n));
+    long chunk = (n + n_threads - 1) / n_threads;
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto run = [&](long begin, long end) {
+        try
+        {
+            body(begin, end);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 1; t < n_threads; ++t)
+    {
+        long begin = t * chunk, end = std::min(n, begin + chunk);
+        if (begin < end)
+            threads.push_back(std::thread(run, begin, end));
+    }
+    run(0, std::min(n, chunk));
+    for (unsigned int t = 0; t < threads.size(); ++t)
+        threads[t].join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+}
@@ -0,0 +1,117 @@
+#include "ParameterSweep.hpp"
+#include "Builder.hpp"
+#include "FilterState.hpp"
+#include "Parallel.hpp"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace linear_system;
+
+StepMetrics linear_system::stepResponseMetrics(const DiscreteRealization &realization, double duration, double band)
+{
+    if (duration <= 0)
+        throw std::logic_error("the simulated horizon must be positive");
+    if (band <= 0)
+        throw std::logic_error("the settling band must be positive");
+
+    const double infinity = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double ts = realization.getSampling();
+
+    StepMetrics metrics;
+    // The steady state of a unit step is H(1)
+    metrics.final_value = realization.getNumerator().sum() / realization.getDenominator().sum();
+    const bool has_gain = std::isfinite(metrics.final_value) && metrics.final_value != 0;
+    const double reference = has_gain ? metrics.final_value : 1;
+
+    FilterState fstate;
+    fstate.reset(1, realization.getOrder());
+    Input u = Input::Ones(1);
+
+    // Response normalized by the steady-state value, so that the levels are 0.1, 0.9 and 1
+    double previous = 0, peak = 0, t10 = infinity, t90 = infinity;
+    long last_outside = -1, n_samples = std::ceil(duration / ts) + 1;
+    for (long k = 0; k < n_samples; ++k)
+    {
+        realization.update(fstate, u);
+        double r = fstate.last_output(0) / reference;
+        if (!std::isfinite(r))
+        {
+            last_outside = n_samples - 1;
+            break;
+        }
+
+        // Crossing times are interpolated between samples
+        if (t10 == infinity && r >= 0.1)
+            t10 = (k - (r - 0.1) / (r - previous)) * ts;
+        if (t90 == infinity && r >= 0.9)
+            t90 = (k - (r - 0.9) / (r - previous)) * ts;
+        peak = std::max(peak, r);
+        if (std::abs(r - (has_gain ? 1 : 0)) > band)
+            last_outside = k;
+        previous = r;
+    }
+
+    metrics.rise_time = has_gain ? t90 - t10 : nan;
+    if (has_gain && t90 == infinity)
+        metrics.rise_time = infinity;
+    metrics.overshoot = has_gain ? std::max(0.0, peak - 1) : nan;
+    metrics.settling_time = (last_outside == n_samples - 1) ? infinity : (last_outside + 1) * ts;
+    return metrics;
+}
+
+Eigen::MatrixXd linear_system::cartesianGrid(const std::vector<Eigen::VectorXd> &axes)
+{
+    Eigen::Index rows = axes.empty() ? 0 : 1;
+    for (const Eigen::VectorXd &axis : axes)
+        rows *= axis.size();
+
+    Eigen::MatrixXd grid(rows, axes.size());
+    Eigen::Index repeat = 1;
+    for (Eigen::Index j = axes.size() - 1; j >= 0; --j)
+    {
+        for (Eigen::Index i = 0; i < rows; ++i)
+            grid(i, j) = axes[j]((i / repeat) % axes[j].size());
+        repeat *= axes[j].size();
+    }
+    return grid;
+}
+
+Eigen::MatrixXd linear_system::sweepStepResponse(const DesignFunction &design, const Eigen::MatrixXd &grid,
+    double duration, double band, unsigned int n_threads)
+{
+    Eigen::MatrixXd table(grid.rows(), 3);
+    parallelFor(grid.rows(), n_threads, [&](long begin, long end) {
+        Eigen::VectorXd parameters(grid.cols());
+        for (long i = begin; i < end; ++i)
+        {
+            parameters = grid.row(i).transpose();
+            StepMetrics metrics = stepResponseMetrics(*design(parameters), duration, band);
+            table(i, 0) = metrics.rise_time;
+            table(i, 1) = metrics.overshoot;
+            table(i, 2) = metrics.settling_time;
+        }
+    });
+    return table;
+}
+
+Eigen::MatrixXd linear_system::sweepSecondOrder(const Eigen::MatrixXd &grid, double duration, double band,
+    unsigned int n_threads)
+{
+    if (grid.cols() != 2)
+        throw std::logic_error("the grid must have two columns, (damp, cutoff)");
+    return sweepStepResponse([](const Eigen::VectorXd &p) {
+        return Builder::createSecondOrder(p(0), p(1)).getRealization();
+    }, grid, duration, band, n_threads);
+}
+
+Eigen::MatrixXd linear_system::sweepReferenceFilter2I(const Eigen::MatrixXd &grid, double duration, double band,
+    unsigned int n_threads)
+{
+    if (grid.cols() != 3)
+        throw std::logic_error("the grid must have three columns, (kp, ki, kd)");
+    return sweepStepResponse([](const Eigen::VectorXd &p) {
+        return Builder::createReferenceFilter2I(p(0), p(1), p(2)).getRealization();
+    }, grid, duration, band, n_threads);
+}
@@ -0,0 +1,228 @@
+#include "PerfEvents.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace linear_system;
+
+namespace
+{
+
+const char *section_names[N_PERF_SECTIONS] = {"update", "discretize", "tf2ss", "setInitialState"};
+
+/*
+ * Group of counters of the calling thread, opened on first use: cycles lead, and instructions,
+ * cache references and cache misses follow, so that one read returns all of them.
+ */
+class ThreadCounters
+{
+private:
+    static const int n_counters = 4;
+    int fds[n_counters];
+    bool available;
+
+public:
+    ThreadCounters() : available(false)
+    {
+        std::fill(fds, fds + n_counters, -1);
+#ifdef __linux__
+        const uint64_t configs[n_counters] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                              PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES};
+        for (int i = 0; i < n_counters; ++i)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = (i == 0);
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, (i == 0) ? -1 : fds[0], 0);
+            if (fds[i] < 0)
+            {
+                close();
+                return;
+            }
+        }
+        available = ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == 0;
+        if (!available)
+            close();
+#endif
+    }
+
+    ~ThreadCounters()
+    {
+        close();
+    }
+
+    void close()
+    {
+#ifdef __linux__
+        for (int i = 0; i < n_counters; ++i)
+        {
+            if (fds[i] >= 0)
+                ::close(fds[i]);
+            fds[i] = -1;
+        }
+#endif
+        available = false;
+    }
+
+    bool isAvailable() const
+    {
+        return available;
+    }
+
+    void read(PerfCounts &counts) const
+    {
+        counts.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        uint64_t values[1 + n_counters] = {0};
+#ifdef __linux__
+        if (available && ::read(fds[0], values, sizeof(values)) != (ssize_t) sizeof(values))
+            std::fill(values, values + 1 + n_counters, 0);
+#endif
+        counts.cycles = values[1];
+        counts.instructions = values[2];
+        counts.cache_references = values[3];
+        counts.cache_misses = values[4];
+    }
+};
+
+ThreadCounters & threadCounters()
+{
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+double perCall(uint64_t total, uint64_t calls)
+{
+    return (calls > 0) ? double(total) / calls : 0;
+}
+
+}
+
+PerfProfile::PerfProfile()
+{
+    reset();
+}
+
+bool PerfProfile::compiledIn()
+{
+#ifdef LINEAR_SYSTEM_PERF_EVENTS
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PerfProfile::countersAvailable()
+{
+    return threadCounters().isAvailable();
+}
+
+PerfProfile & PerfProfile::global()
+{
+    static PerfProfile profile;
+    return profile;
+}
+
+const char * PerfProfile::sectionName(PerfSection section)
+{
+    return section_names[section];
+}
+
+void PerfProfile::add(PerfSection section, const PerfCounts &counts)
+{
+    Section &s = sections[section];
+    s.calls.fetch_add(counts.calls, std::memory_order_relaxed);
+    s.nanoseconds.fetch_add(counts.nanoseconds, std::memory_order_relaxed);
+    s.cycles.fetch_add(counts.cycles, std::memory_order_relaxed);
+    s.instructions.fetch_add(counts.instructions, std::memory_order_relaxed);
+    s.cache_references.fetch_add(counts.cache_references, std::memory_order_relaxed);
+    s.cache_misses.fetch_add(counts.cache_misses, std::memory_order_relaxed);
+}
+
+PerfCounts PerfProfile::get(PerfSection section) const
+{
+    const Section &s = sections[section];
+    PerfCounts counts;
+    counts.calls = s.calls.load(std::memory_order_relaxed);
+    counts.nanoseconds = s.nanoseconds.load(std::memory_order_relaxed);
+    counts.cycles = s.cycles.load(std::memory_order_relaxed);
+    counts.instructions = s.instructions.load(std::memory_order_relaxed);
+    counts.cache_references = s.cache_references.load(std::memory_order_relaxed);
+    counts.cache_misses = s.cache_misses.load(std::memory_order_relaxed);
+    return counts;
+}
+
+void PerfProfile::reset()
+{
+    for (Section &s : sections)
+    {
+        s.calls = 0;
+        s.nanoseconds = 0;
+        s.cycles = 0;
+        s.instructions = 0;
+        s.cache_references = 0;
+        s.cache_misses = 0;
+    }
+}
+
+void PerfProfile::report(std::ostream &out, const std::string &name) const
+{
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << "[PERF] " << (name.empty() ? "profile" : name);
+    if (!compiledIn())
+        out << " (instrumentation not compiled in, see LINEAR_SYSTEM_PERF_EVENTS)";
+    out << std::endl << std::left << std::setprecision(4)
+        << "  " << std::setw(16) << "section" << std::setw(12) << "calls" << std::setw(12) << "ns/call"
+        << std::setw(12) << "cycles/call" << std::setw(12) << "instr/call" << std::setw(12) << "misses/call"
+        << std::setw(8) << "IPC" << "miss ratio" << std::endl;
+    for (int i = 0; i < N_PERF_SECTIONS; ++i)
+    {
+        PerfCounts c = get(PerfSection(i));
+        if (c.calls == 0)
+            continue;
+        out << "  " << std::setw(16) << section_names[i] << std::setw(12) << c.calls
+            << std::setw(12) << perCall(c.nanoseconds, c.calls) << std::setw(12) << perCall(c.cycles, c.calls)
+            << std::setw(12) << perCall(c.instructions, c.calls) << std::setw(12) << perCall(c.cache_misses, c.calls)
+            << std::setw(8) << perCall(c.instructions, c.cycles) << perCall(c.cache_misses, c.cache_references)
+            << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+PerfScope::PerfScope(PerfProfile *profile, PerfSection section) :
+    profile(profile), section(section)
+{
+    if (profile)
+        threadCounters().read(start);
+}
+
+PerfScope::~PerfScope()
+{
+    if (!profile)
+        return;
+    PerfCounts end;
+    threadCounters().read(end);
+    end.calls = 1;
+    end.nanoseconds -= start.nanoseconds;
+    end.cycles -= start.cycles;
+    end.instructions -= start.instructions;
+    end.cache_references -= start.cache_references;
+    end.cache_misses -= start.cache_misses;
+    profile->add(section, end);
+}
@@ -0,0 +1,52 @@
+#include "ThreadPool.hpp"
+#include "Parallel.hpp"
+#include <stdexcept>
+
+using namespace linear_system;
+
+ThreadPool::ThreadPool(unsigned int n_threads) : stopping(false)
+{
+    n_threads = resolveThreads(n_threads);
+    for (unsigned int t = 0; t < n_threads; ++t)
+        workers.push_back(std::thread(&ThreadPool::work, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping)
+            throw std::logic_error("cannot submit tasks to a stopping thread pool");
+        tasks.push_back(std::move(task));
+    }
+    available.notify_one();
+}
+
+void ThreadPool::work()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this]() {return stopping || !tasks.empty();});
+            if (tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        // Exceptions are stored in the future by the packaged task
+        task();
+    }
+}
@@ -0,0 +1,64 @@
+#include "Unwrap.hpp"
+#include <stdexcept>
+
+using namespace linear_system;
+
+namespace
+{
+
+const double inv_two_pi = 0.15915494309189535;
+
+// Rounds |x| < 2^51 to the nearest integer, as in HelperFunctions.cpp
+const double round_magic = 6755399441055744.0;
+
+}
+
+Unwrapper::Unwrapper(unsigned int n_channels) :
+    previous(Eigen::VectorXd::Zero(n_channels)), turns(Eigen::VectorXd::Zero(n_channels)), started(false)
+{
+    if (n_channels == 0)
+        throw std::logic_error("received n_channels = 0, but Unwrapper must implement at least one channel");
+}
+
+void Unwrapper::reset()
+{
+    previous.setZero();
+    turns.setZero();
+    started = false;
+}
+
+void Unwrapper::update(const Eigen::Ref<const Eigen::VectorXd> &angles, Eigen::Ref<Eigen::VectorXd> unwrapped)
+{
+    const Eigen::Index n = previous.size();
+    if (angles.size() != n || unwrapped.size() != n)
+        throw std::logic_error("the number of angles must match the number of channels");
+
+    if (!started)
+    {
+        previous = angles;
+        unwrapped = angles;
+        started = true;
+        return;
+    }
+
+    // Jumps larger than pi are taken as whole turns, counted in t
+    const double *a = angles.data();
+    double *p = previous.data(), *t = turns.data(), *y = unwrapped.data();
+    for (Eigen::Index i = 0; i < n; ++i)
+    {
+        double jump = ((a[i] - p[i]) * inv_two_pi + round_magic) - round_magic;
+        t[i] -= jump;
+        p[i] = a[i];
+        y[i] = a[i] + 2 * M_PI * t[i];
+    }
+}
+
+void Unwrapper::process(const Eigen::MatrixXd &input, Eigen::MatrixXd &output)
+{
+    if (input.rows() != previous.size())
+        throw std::logic_error("the number of input channels is different from the number of channels");
+
+    output.resize(input.rows(), input.cols());
+    for (Eigen::Index k = 0; k < input.cols(); ++k)
+        update(input.col(k), output.col(k));
+}
@@ -0,0 +1,98 @@
+#include "VariableStep.hpp"
+#include "MIMORealization.hpp"
+#include <stdexcept>
+
+using namespace linear_system;
+
+namespace
+{
+
+// Irregular clocks only produce a few distinct elapsed times once quantized; the cache starts
+// over past this size so that an unbounded variety of them cannot grow it forever
+const std::size_t max_cached_steps = 1024;
+
+}
+
+VariableStepSystem::VariableStepSystem(std::shared_ptr<const DiscreteRealization> realization, Time quantum) :
+    realization(std::move(realization)), quantum(quantum), state_time(0), time_init_set(false)
+{
+    if (!this->realization)
+        throw std::logic_error("received an empty realization");
+    if (!this->realization->hasContinuousModel())
+        throw std::logic_error("variable steps require a continuous-time model");
+    if (quantum <= 0)
+        throw std::logic_error("the time quantum must be positive");
+
+    DiscreteRealization::tf2ss(this->realization->getContinuousNumerator(), this->realization->getContinuousDenominator(),
+                               Ac, Bc, Cc, Dc);
+    useNFilters(1);
+}
+
+void VariableStepSystem::useNFilters(unsigned int n_filters)
+{
+    if (n_filters == 0)
+        throw std::logic_error("received n_filters = 0, but VariableStepSystem must implement at least one filter");
+
+    state.setZero(n_filters, Ac.rows());
+    next.resize(n_filters, Ac.rows());
+    held_input.setZero(n_filters);
+    last_output.setZero(n_filters);
+}
+
+const VariableStepSystem::Step & VariableStepSystem::step(Time multiple)
+{
+    std::unordered_map<Time, Step>::const_iterator it = steps.find(multiple);
+    if (it != steps.end())
+        return it->second;
+
+    if (steps.size() >= max_cached_steps)
+        steps.clear();
+
+    // expm([Ac Bc; 0 0] dt) = [Phi Gamma; 0 1]
+    Eigen::MatrixXd Phi, Gamma, C, D;
+    MIMORealization::discretize(Ac, Bc, Cc, Eigen::MatrixXd::Constant(1, 1, Dc), multiple * quantum * 1e-6, ZOH, 0,
+                                Phi, Gamma, C, D);
+    Step &s = steps[multiple];
+    s.Phi = Phi;
+    s.Gamma = Gamma.col(0);
+    return s;
+}
+
+Output VariableStepSystem::update(const Input &signalIn, Time time)
+{
+    Output output(state.rows());
+    update(signalIn, time, output);
+    return output;
+}
+
+void VariableStepSystem::update(const Input &signalIn, Time time, Eigen::Ref<Output> output)
+{
+    if (signalIn.size() != state.rows() || output.size() != state.rows())
+        throw std::logic_error("the number of inputs and outputs must match the number of filters");
+    if (!time_init_set)
+        throw std::logic_error("the initial time is not set");
+
+    // Elapsed time in whole quanta, rounded to nearest; the remainder is left in
+    // time - state_time for the next update
+    Time multiple = (time - state_time + quantum / 2) / quantum;
+    if (time > state_time && multiple > 0)
+    {
+        const Step &s = step(multiple);
+        next.noalias() = state * s.Phi.transpose();
+        next.noalias() += held_input.transpose() * s.Gamma.transpose();
+        state.swap(next);
+        state_time += multiple * quantum;
+    }
+
+    last_output.noalias() = state * Cc.transpose();
+    last_output += Dc * signalIn.transpose();
+    held_input = signalIn;
+    output = last_output;
+}
+
+void VariableStepSystem::setState(const Eigen::MatrixXd &state)
+{
+    if (state.rows() != this->state.rows() || state.cols() != this->state.cols())
+        throw std::logic_error("the state must have one row per filter and one column per state");
+    this->state = state;
+}
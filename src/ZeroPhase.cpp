@@ -0,0 +1,83 @@
+#include "ZeroPhase.hpp"
+#include "BlockFilter.hpp"
+#include "Parallel.hpp"
+#include <stdexcept>
+#include <vector>
+
+using namespace linear_system;
+
+namespace
+{
+
+// Channels per block, as in simulateBatch
+const Eigen::Index block_size = 256;
+
+}
+
+Eigen::MatrixXd linear_system::filtfilt(const DiscreteRealization &realization, const Eigen::MatrixXd &input,
+    int padlen, unsigned int n_threads)
+{
+    const unsigned int order = realization.getOrder();
+    const Eigen::Index N = input.cols();
+    const Eigen::Index p = (padlen < 0) ? 3 * (order + 1) : padlen;
+    if (p >= N)
+        throw std::logic_error("the input must be longer than the padding");
+
+    // Each pass starts from the steady state of its first input, which setInitialState would
+    // give from constant inputs and outputs; it scales the unit one, computed once
+    const Eigen::VectorXd unit_state = realization.unitSteadyState();
+
+    std::vector<MatrixEntry<> > a_entries = nonzeroEntries(realization.getA());
+
+    Eigen::MatrixXd output(input.rows(), N);
+    const long n_blocks = (input.rows() + block_size - 1) / block_size;
+    parallelFor(n_blocks, n_threads, [&](long begin, long end) {
+        Eigen::VectorXd u, first, last;
+        Eigen::MatrixXd right_pad;
+        for (long b = begin; b < end; ++b)
+        {
+            const Eigen::Index row = b * block_size, rows = std::min(block_size, input.rows() - row);
+            BlockFilter filter(realization, a_entries, rows);
+            auto x = [&](Eigen::Index k) {return input.col(k).segment(row, rows);};
+            auto y = [&](Eigen::Index k) {return output.col(k).segment(row, rows);};
+            first = 2 * x(0);
+            last = 2 * x(N - 1);
+
+            // Forward pass over the reflected extensions, the forward outputs of the right
+            // one being kept for the backward pass
+            u = first - x(p);
+            filter.start(unit_state, u);
+            for (Eigen::Index k = p; k > 0; --k)
+            {
+                u = first - x(k);
+                filter.step(u, u);
+            }
+            for (Eigen::Index k = 0; k < N; ++k)
+                filter.step(x(k), y(k));
+            right_pad.resize(rows, p);
+            for (Eigen::Index k = 0; k < p; ++k)
+            {
+                u = last - x(N - 2 - k);
+                filter.step(u, right_pad.col(k));
+            }
+
+            // Backward pass, from the steady state of the last forward output, overwriting
+            // the forward outputs with the final ones
+            if (p > 0)
+                filter.start(unit_state, right_pad.col(p - 1));
+            else
+                filter.start(unit_state, y(N - 1));
+            for (Eigen::Index k = p - 1; k >= 0; --k)
+            {
+                u = right_pad.col(k);
+                filter.step(u, u);
+            }
+            for (Eigen::Index k = N - 1; k >= 0; --k)
+            {
+                u = y(k);
+                filter.step(u, y(k));
+            }
+        }
+    });
+    return output;
+}
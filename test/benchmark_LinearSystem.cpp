@@ -0,0 +1,742 @@
+#include <LinearSystem.hpp>
+#include <HelperFunctions.hpp>
+#include <Builder.hpp>
+#include <DesignCache.hpp>
+#include <FilterArena.hpp>
+#include <FrequencyResponse.hpp>
+#include <BatchSimulation.hpp>
+#include <ParameterSweep.hpp>
+#include <FixedFilter.hpp>
+#include <FilterBank.hpp>
+#include <FixedPoint.hpp>
+#include <CoefficientBank.hpp>
+#include <ConvolutionEngine.hpp>
+#include <ZeroPhase.hpp>
+#include <VariableStep.hpp>
+#include <PerfEvents.hpp>
+#include <Unwrap.hpp>
+#include <Polynomial.hpp>
+#include <Interconnection.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace linear_system;
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(const Clock::time_point &start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void printResult(const std::string &name, double value, const std::string &unit)
+{
+    std::cout << "  " << name << ": " << value << " " << unit << std::endl;
+}
+
+/*
+ * Startup time and update throughput of many small filters whose states come from the
+ * global heap versus a shared FilterArena.
+ */
+void benchmarkArena()
+{
+    const unsigned int n_systems = 20000, n_threads = 4, n_steps = 200;
+    std::cout << "[BENCHMARK] heap vs arena (" << n_systems << " filters, " << n_threads << " threads)" << std::endl;
+
+    std::shared_ptr<const DiscreteRealization> realization = Builder::createSecondOrder(0.7, 10).getRealization();
+    const unsigned int per_thread = n_systems / n_threads;
+
+    for (int use_arena = 0; use_arena < 2; ++use_arena)
+    {
+        FilterArena arena(n_systems * 2 * FilterArena::alignment);
+        std::vector<std::vector<LinearSystem> > systems(n_threads);
+
+        Clock::time_point start = Clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < n_threads; ++t)
+        {
+            threads.push_back(std::thread([&, t]() {
+                systems[t].reserve(per_thread);
+                for (unsigned int k = 0; k < per_thread; ++k)
+                {
+                    if (use_arena)
+                        systems[t].push_back(LinearSystem(realization, arena));
+                    else
+                        systems[t].push_back(LinearSystem(realization));
+                    systems[t].back().setInitialTime(0);
+                }
+            }));
+        }
+        for (unsigned int t = 0; t < n_threads; ++t)
+            threads[t].join();
+        double startup = secondsSince(start);
+
+        Input u = Input::Ones(1);
+        Output y(1);
+        Time step = realization->getSampling() * 1000000L;
+        start = Clock::now();
+        for (unsigned int k = 1; k <= n_steps; ++k)
+        {
+            for (unsigned int t = 0; t < n_threads; ++t)
+            {
+                for (unsigned int i = 0; i < per_thread; ++i)
+                    systems[t][i].update(u, k * step, y);
+            }
+        }
+        double elapsed = secondsSince(start);
+
+        std::string label = use_arena ? "arena" : "heap";
+        printResult(label + " startup", startup * 1e3, "ms");
+        printResult(label + " update", n_systems * (double) n_steps / elapsed / 1e6, "Mupdates/s");
+    }
+}
+
+/*
+ * Frequency-response sweep of a bank of filters over a dense grid.
+ */
+void benchmarkFrequencyResponse()
+{
+    const unsigned int n_filters = 100, n_frequencies = 100000;
+    std::cout << "[BENCHMARK] frequency response (" << n_filters << " filters, " << n_frequencies << " frequencies)" << std::endl;
+
+    std::vector<std::shared_ptr<const DiscreteRealization> > bank;
+    for (unsigned int i = 0; i < n_filters; ++i)
+        bank.push_back(Builder::createSecondOrder(0.5 + 0.004 * i, 1 + i).getRealization());
+    Eigen::VectorXd omega = Eigen::VectorXd::LinSpaced(n_frequencies, 0, 3000);
+
+    for (unsigned int n_threads = 1; n_threads <= 4; n_threads *= 2)
+    {
+        Clock::time_point start = Clock::now();
+        Eigen::MatrixXcd h = discreteResponse(bank, omega, n_threads);
+        double elapsed = secondsSince(start);
+        printResult(std::to_string(n_threads) + " thread(s)", n_filters * (double) n_frequencies / elapsed / 1e6, "Mpoints/s");
+    }
+}
+
+/*
+ * Anti-aliasing filters at 8 kHz whose outputs are consumed at 1 kHz, full rate versus
+ * decimating, for an IIR and an FIR filter.
+ */
+void benchmarkDecimator()
+{
+    const unsigned int factor = 8, n_channels = 64, n_samples = 80000;
+    std::cout << "[BENCHMARK] decimation by " << factor << " (" << n_channels << " channels)" << std::endl;
+    double ts = 1.0 / 8000;
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(n_channels, n_samples);
+    Eigen::MatrixXd output;
+
+    Decimator decimators[] = {Builder::createDecimator(factor, ts), Builder::createMovingAverageDecimator(factor, ts)};
+    const char *names[] = {"butterworth", "moving average"};
+    for (int i = 0; i < 2; ++i)
+    {
+        LinearSystem full(decimators[i].getRealization());
+        full.useNFilters(n_channels);
+        full.setInitialTime(0);
+        Output y(n_channels);
+        Input u(n_channels);
+        Time step = full.getSamplingMicro();
+        Clock::time_point start = Clock::now();
+        for (unsigned int k = 0; k < n_samples; ++k)
+        {
+            u = input.col(k).transpose();
+            full.update(u, (k + 1) * step, y);
+        }
+        double elapsed_full = secondsSince(start);
+
+        Decimator decimator(decimators[i].getRealization(), factor, n_channels);
+        start = Clock::now();
+        decimator.process(input, output);
+        double elapsed_dec = secondsSince(start);
+
+        printResult(std::string(names[i]) + " full rate", n_channels * (double) n_samples / elapsed_full / 1e6, "Msamples/s");
+        printResult(std::string(names[i]) + " decimating", n_channels * (double) n_samples / elapsed_dec / 1e6, "Msamples/s");
+    }
+}
+
+/*
+ * Monte Carlo run of one filter over many random input trajectories, one filter object per
+ * scenario versus the batched API.
+ */
+void benchmarkBatch()
+{
+    const unsigned int n_scenarios = 4096, n_samples = 2000;
+    std::cout << "[BENCHMARK] batched scenarios (" << n_scenarios << " scenarios, " << n_samples << " samples)" << std::endl;
+    std::shared_ptr<const DiscreteRealization> realization = Builder::createSecondOrder(0.7, 10).getRealization();
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(n_scenarios, n_samples);
+    Eigen::MatrixXd output(n_scenarios, n_samples);
+
+    Clock::time_point start = Clock::now();
+    Input u(1);
+    Output y(1);
+    Time step = realization->getSampling() * 1000000L;
+    for (unsigned int i = 0; i < n_scenarios; ++i)
+    {
+        LinearSystem sys(realization);
+        sys.setInitialTime(0);
+        for (unsigned int k = 0; k < n_samples; ++k)
+        {
+            u(0) = input(i, k);
+            sys.update(u, (k + 1) * step, y);
+            output(i, k) = y(0);
+        }
+    }
+    printResult("one filter per scenario", n_scenarios * (double) n_samples / secondsSince(start) / 1e6, "Msamples/s");
+
+    for (unsigned int n_threads = 1; n_threads <= 4; n_threads *= 2)
+    {
+        start = Clock::now();
+        output = simulateBatch(*realization, input, n_threads);
+        printResult("batched, " + std::to_string(n_threads) + " thread(s)",
+                    n_scenarios * (double) n_samples / secondsSince(start) / 1e6, "Msamples/s");
+    }
+}
+
+/*
+ * One long channel, sequentially and split in time across threads.
+ */
+void benchmarkParallelInTime()
+{
+    const unsigned int n_samples = 1 << 22;
+    std::cout << "[BENCHMARK] parallel in time (" << n_samples << " samples, "
+              << std::thread::hardware_concurrency() << " hardware threads)" << std::endl;
+    std::shared_ptr<const DiscreteRealization> realization = Builder::createSecondOrder(0.7, 10).getRealization();
+    Eigen::VectorXd input = Eigen::VectorXd::Random(n_samples);
+
+    Clock::time_point start = Clock::now();
+    Eigen::MatrixXd sequential = simulateBatch(*realization, input.transpose());
+    printResult("sequential", n_samples / secondsSince(start) / 1e6, "Msamples/s");
+    for (unsigned int n_threads = 1; n_threads <= 8; n_threads *= 2)
+    {
+        start = Clock::now();
+        Eigen::VectorXd output = simulateParallelInTime(*realization, input, n_threads);
+        printResult(std::to_string(n_threads) + " thread(s)", n_samples / secondsSince(start) / 1e6, "Msamples/s");
+    }
+}
+
+/*
+ * Zero-phase filtering of large arrays, against a single forward pass.
+ */
+void benchmarkFiltfilt()
+{
+    const unsigned int n_channels = 64, n_samples = 200000;
+    std::cout << "[BENCHMARK] filtfilt (" << n_channels << " channels, " << n_samples << " samples)" << std::endl;
+    const double w = 2 * M_PI * 10;
+    std::shared_ptr<const DiscreteRealization> realization =
+        DesignCache::instance().get(Poly::Constant(1, w * w), Eigen::Vector3d(1, 1.4 * w, w * w), 0.001, TUSTIN, 0);
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(n_channels, n_samples);
+
+    Clock::time_point start = Clock::now();
+    Eigen::MatrixXd output = simulateBatch(*realization, input);
+    printResult("forward only", input.size() / secondsSince(start) / 1e6, "Msamples/s");
+    for (unsigned int n_threads = 1; n_threads <= 4; n_threads *= 2)
+    {
+        start = Clock::now();
+        output = filtfilt(*realization, input, -1, n_threads);
+        printResult("filtfilt, " + std::to_string(n_threads) + " thread(s)", input.size() / secondsSince(start) / 1e6, "Msamples/s");
+    }
+}
+
+/*
+ * Step-response metrics over a (kp, ki, kd) grid of reference filters.
+ */
+void benchmarkSweep()
+{
+    std::vector<Eigen::VectorXd> axes(3);
+    axes[0] = Eigen::VectorXd::LinSpaced(20, 1, 20);
+    axes[1] = Eigen::VectorXd::LinSpaced(10, 0.5, 5);
+    axes[2] = Eigen::VectorXd::LinSpaced(10, 0.1, 1);
+    Eigen::MatrixXd grid = cartesianGrid(axes);
+    std::cout << "[BENCHMARK] step-response sweep (" << grid.rows() << " candidates, 10 s)" << std::endl;
+
+    for (unsigned int n_threads = 1; n_threads <= 4; n_threads *= 2)
+    {
+        Clock::time_point start = Clock::now();
+        Eigen::MatrixXd table = sweepReferenceFilter2I(grid, 10, 0.02, n_threads);
+        printResult(std::to_string(n_threads) + " thread(s)", grid.rows() / secondsSince(start), "candidates/s");
+    }
+}
+
+/*
+ * Startup and update cost of a second-order filter designed at compile time versus at runtime.
+ */
+void benchmarkFixed()
+{
+    const unsigned int n_designs = 10000, n_samples = 10000000;
+    std::cout << "[BENCHMARK] compile-time design (second order)" << std::endl;
+
+    Clock::time_point start = Clock::now();
+    for (unsigned int i = 0; i < n_designs; ++i)
+        DiscreteRealization realization(Eigen::Vector3d(0, 100 + i, 0), Eigen::Vector3d(1, 14, 100 + i), 0.001, TUSTIN, 0);
+    printResult("runtime design", secondsSince(start) / n_designs * 1e6, "us");
+
+    constexpr FixedCoefficients<2> coefficients = design::secondOrder<TUSTIN>(0.7, 10, 0.001);
+    FixedFilter<2> fixed(coefficients);
+    LinearSystem dynamic(realize(coefficients));
+    dynamic.setInitialTime(0);
+    Input u(1);
+    Output y(1);
+    double sum = 0;
+    start = Clock::now();
+    for (unsigned int k = 0; k < n_samples; ++k)
+        sum += fixed.update(k & 1);
+    printResult("FixedFilter update", n_samples / secondsSince(start) / 1e6, "Mupdates/s");
+
+    start = Clock::now();
+    for (unsigned int k = 0; k < n_samples; ++k)
+    {
+        u(0) = k & 1;
+        dynamic.update(u, (k + 1) * 1000L, y);
+        sum -= y(0);
+    }
+    printResult("LinearSystem update", n_samples / secondsSince(start) / 1e6, "Mupdates/s");
+    printResult("output difference", sum, "");
+}
+
+template<typename Bank>
+void runPrecision(const std::string &name, const std::shared_ptr<const DiscreteRealization> &realization,
+    const Eigen::MatrixXd &input, const Eigen::MatrixXd &reference)
+{
+    typedef typename Bank::Matrix Matrix;
+    Bank bank(realization, input.rows());
+    Matrix input_cast = input.cast<typename Matrix::Scalar>(), output;
+    Clock::time_point start = Clock::now();
+    bank.process(input_cast, output);
+    double elapsed = secondsSince(start);
+    double drift = (output.template cast<double>() - reference).cwiseAbs().maxCoeff() / reference.cwiseAbs().maxCoeff();
+    printResult(name, input.size() / elapsed / 1e6, "Msamples/s");
+    printResult(name + " relative drift", drift, "");
+}
+
+/*
+ * Throughput and accuracy drift of double, float and mixed precision banks, against the
+ * double-precision LinearSystem.
+ */
+void benchmarkPrecision()
+{
+    const unsigned int n_filters = 512, n_samples = 20000;
+    std::cout << "[BENCHMARK] precision (" << n_filters << " filters, " << n_samples << " samples)" << std::endl;
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(n_filters, n_samples);
+
+    const char *names[] = {"second order", "reference filter 2I"};
+    std::shared_ptr<const DiscreteRealization> realizations[] = {
+        Builder::createSecondOrder(0.7, 10).getRealization(),
+        Builder::createReferenceFilter2I(20, 50, 1).getRealization()};
+    for (int i = 0; i < 2; ++i)
+    {
+        std::cout << " " << names[i] << std::endl;
+        LinearSystem sys(realizations[i]);
+        sys.useNFilters(n_filters);
+        sys.setInitialTime(0);
+        Eigen::MatrixXd reference(n_filters, n_samples);
+        Output y(n_filters);
+        Input u(n_filters);
+        Time step = sys.getSamplingMicro();
+        Clock::time_point start = Clock::now();
+        for (unsigned int k = 0; k < n_samples; ++k)
+        {
+            u = input.col(k).transpose();
+            sys.update(u, (k + 1) * step, y);
+            reference.col(k) = y;
+        }
+        printResult("LinearSystem", input.size() / secondsSince(start) / 1e6, "Msamples/s");
+
+        runPrecision<DoubleFilterBank>("double", realizations[i], input, reference);
+        runPrecision<FloatFilterBank>("float", realizations[i], input, reference);
+        runPrecision<MixedFilterBank>("float/double", realizations[i], input, reference);
+    }
+}
+
+/*
+ * Integer-only updates of a fixed-point filter versus the double-precision paths.
+ */
+void benchmarkFixedPoint()
+{
+    const unsigned int n_samples = 10000000;
+    std::cout << "[BENCHMARK] fixed point (second order)" << std::endl;
+    std::shared_ptr<const DiscreteRealization> realization = Builder::createReferenceFilter2I(20, 50, 1).getRealization();
+    FixedPointFilter fixed_point(std::make_shared<const FixedPointRealization>(*realization, 1));
+
+    std::vector<int32_t> input(1024);
+    for (unsigned int k = 0; k < input.size(); ++k)
+        input[k] = fixed_point.getRealization()->quantizeInput(std::sin(0.01 * k));
+    int64_t checksum = 0;
+    Clock::time_point start = Clock::now();
+    for (unsigned int k = 0; k < n_samples; ++k)
+        checksum += fixed_point.update(input[k & 1023]);
+    printResult("int32 update", n_samples / secondsSince(start) / 1e6, "Mupdates/s");
+
+    LinearSystem sys(realization);
+    sys.setInitialTime(0);
+    Input u(1);
+    Output y(1);
+    double sum = 0;
+    start = Clock::now();
+    for (unsigned int k = 0; k < n_samples; ++k)
+    {
+        u(0) = std::ldexp((double) input[k & 1023], -fixed_point.getRealization()->getSignalFractionalBits());
+        sys.update(u, (k + 1) * sys.getSamplingMicro(), y);
+        sum += y(0);
+    }
+    printResult("LinearSystem update", n_samples / secondsSince(start) / 1e6, "Mupdates/s");
+    double fixed_sum = std::ldexp((double) checksum, -fixed_point.getRealization()->getOutputFractionalBits());
+    printResult("mean output difference", (sum - fixed_sum) / n_samples, "");
+}
+
+/*
+ * Update throughput of a bank of 8th order Butterworth filters in the controllable canonical,
+ * modal and balanced forms.
+ */
+void benchmarkRealizationForms()
+{
+    const unsigned int order = 8, n_filters = 64, n_samples = 20000;
+    std::cout << "[BENCHMARK] realization forms (order " << order << ", " << n_filters << " filters)" << std::endl;
+    const double cutoff = 2 * M_PI * 5, ts = 0.001;
+    Poly den = Poly::Ones(1);
+    for (unsigned int k = 0; k < order / 2; ++k)
+    {
+        Poly section(3), product = Poly::Zero(den.size() + 2);
+        section << 1, 2 * std::sin(M_PI * (2 * k + 1) / (2 * order)) * cutoff, cutoff * cutoff;
+        for (Eigen::Index i = 0; i < den.size(); ++i)
+            product.segment(i, 3) += den(i) * section;
+        den = product;
+    }
+    Poly num = Poly::Constant(1, std::pow(cutoff, order));
+
+    const RealizationForm forms[] = {CONTROLLABLE_CANONICAL, MODAL, BALANCED};
+    const char *names[] = {"canonical", "modal", "balanced"};
+    Input u = Input::Random(n_filters);
+    Output y(n_filters);
+    for (int f = 0; f < 3; ++f)
+    {
+        LinearSystem sys(num, den, ts, TUSTIN, 0, forms[f]);
+        sys.useNFilters(n_filters);
+        sys.setInitialTime(0);
+        Clock::time_point start = Clock::now();
+        for (unsigned int k = 0; k < n_samples; ++k)
+            sys.update(u, (k + 1) * sys.getSamplingMicro(), y);
+        printResult(names[f], n_filters * (double) n_samples / secondsSince(start) / 1e6, "Msamples/s");
+    }
+}
+
+/*
+ * Configuring many second order filters with different parameters, one by one and in a
+ * single vectorized call, then running them as a bank.
+ */
+void benchmarkCoefficientBank()
+{
+    const unsigned int n_filters = 10000, n_samples = 1000;
+    std::cout << "[BENCHMARK] coefficient bank (" << n_filters << " filters)" << std::endl;
+    Eigen::VectorXd damp = Eigen::VectorXd::LinSpaced(n_filters, 0.1, 2);
+    Eigen::VectorXd cutoff = Eigen::VectorXd::Constant(n_filters, 10);
+
+    Clock::time_point start = Clock::now();
+    std::vector<LinearSystem> systems;
+    systems.reserve(n_filters);
+    for (unsigned int i = 0; i < n_filters; ++i)
+        systems.push_back(Builder::createSecondOrder(damp(i), cutoff(i)));
+    printResult("one by one", secondsSince(start) * 1e3, "ms");
+
+    DesignCache::instance().clear();
+    start = Clock::now();
+    CoefficientBank bank = Builder::createSecondOrderBank(damp, cutoff);
+    printResult("vectorized", secondsSince(start) * 1e3, "ms");
+
+    Eigen::VectorXd u = Eigen::VectorXd::Random(n_filters), y(n_filters);
+    start = Clock::now();
+    for (unsigned int k = 0; k < n_samples; ++k)
+        bank.update(u, y);
+    printResult("update", n_filters * (double) n_samples / secondsSince(start) / 1e6, "Msamples/s");
+}
+
+/*
+ * Recursion versus partitioned FFT convolution for FIR filters of increasing length, with the
+ * path the automatic selection picks.
+ */
+void benchmarkConvolution()
+{
+    const unsigned int n_filters = 16, n_samples = 1 << 15;
+    std::cout << "[BENCHMARK] convolution (" << n_filters << " filters, " << n_samples << " samples)" << std::endl;
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(n_filters, n_samples), output;
+    const char *modes[] = {"automatic", "recurrence", "overlap-save"};
+
+    const unsigned int lengths[] = {16, 64, 256, 1024, 4096};
+    const unsigned int blocks[] = {64, 256, 1024};
+    for (unsigned int length : lengths)
+    {
+        Poly num = Poly::Random(length), den = Poly::Zero(length);
+        den(0) = 1;
+        std::shared_ptr<const DiscreteRealization> filter = DesignCache::instance().get(num, den, 0.001, DIRECT, 0);
+        for (unsigned int block : blocks)
+        {
+            std::cout << " length " << length << ", block " << block << " (automatic: "
+                      << modes[ConvolutionEngine(filter, n_filters, block).getMode()] << ")" << std::endl;
+            for (ConvolutionMode mode : {RECURRENCE, OVERLAP_SAVE})
+            {
+                ConvolutionEngine engine(filter, n_filters, block, mode);
+                Clock::time_point start = Clock::now();
+                engine.process(input, output);
+                printResult(modes[mode], input.size() / secondsSince(start) / 1e6, "Msamples/s");
+            }
+        }
+    }
+}
+
+/*
+ * Jittery clock: the fixed-step filter catching up whole periods versus variable steps, with
+ * the discretizations cached at 1 us and at 100 us resolution.
+ */
+void benchmarkVariableStep()
+{
+    const unsigned int n_updates = 200000;
+    std::cout << "[BENCHMARK] variable step (" << n_updates << " updates, 1 ms +- 30% clock)" << std::endl;
+    const double w = 2 * M_PI * 10;
+    std::shared_ptr<const DiscreteRealization> filter =
+        DesignCache::instance().get(Poly::Constant(1, w * w), Eigen::Vector3d(1, 1.4 * w, w * w), 0.001, ZOH, 0);
+    std::vector<Time> times(n_updates);
+    Time time = 0;
+    for (unsigned int k = 0; k < n_updates; ++k)
+        times[k] = time += 700 + (k * 7919) % 600;
+    Input u = Input::Random(1);
+
+    LinearSystem fixed(filter);
+    fixed.setInitialTime(0);
+    Clock::time_point start = Clock::now();
+    for (Time t : times)
+        fixed.update(u, t);
+    printResult("fixed step", n_updates / secondsSince(start) / 1e6, "Mupdates/s");
+
+    for (Time quantum : {1, 100})
+    {
+        VariableStepSystem variable(filter, quantum);
+        variable.setInitialTime(0);
+        start = Clock::now();
+        for (Time t : times)
+            variable.update(u, t);
+        std::cout << " quantum " << quantum << " us, " << variable.getCacheSize() << " cached steps" << std::endl;
+        printResult("variable step", n_updates / secondsSince(start) / 1e6, "Mupdates/s");
+    }
+}
+
+/*
+ * Hardware counters of bank updates of increasing size: past the caches the cycles per sample
+ * climb with the misses. Only meaningful with LINEAR_SYSTEM_PERF_EVENTS.
+ */
+void benchmarkPerfEvents()
+{
+    std::cout << "[BENCHMARK] perf events (counters " << (PerfProfile::countersAvailable() ? "available" : "unavailable")
+              << ")" << std::endl;
+    std::shared_ptr<const DiscreteRealization> filter = Builder::createSecondOrder(0.7, 10).getRealization();
+    for (unsigned int n_filters : {1000, 10000, 100000, 1000000})
+    {
+        DoubleFilterBank bank(filter, n_filters);
+        std::shared_ptr<PerfProfile> profile = std::make_shared<PerfProfile>();
+        bank.setProfile(profile);
+        Eigen::VectorXd u = Eigen::VectorXd::Random(n_filters), y(n_filters);
+        for (unsigned int k = 0; k < 100000000 / n_filters; ++k)
+            bank.update(u, y);
+
+        PerfCounts counts = profile->get(PERF_UPDATE);
+        std::ostringstream name;
+        name << n_filters << " filters";
+        profile->report(std::cout, name.str());
+        double samples = double(counts.calls) * n_filters;
+        if (counts.calls > 0)
+            printResult("time", counts.nanoseconds / samples, "ns/sample");
+        if (counts.calls > 0 && PerfProfile::countersAvailable())
+        {
+            printResult("cycles", counts.cycles / samples, "per sample");
+            printResult("cache misses", counts.cache_misses / samples, "per sample");
+        }
+    }
+}
+
+/*
+ * Angle pipelines: the bulk wrap2pi kernel against the former per-element std::fmod loop, and
+ * unwrapping fused in front of a bank, sample by sample, against two passes over a block.
+ */
+void benchmarkAngles()
+{
+    const unsigned int n_channels = 10000, n_samples = 200;
+    std::cout << "[BENCHMARK] angles (" << n_channels << " channels, " << n_samples << " samples)" << std::endl;
+    Eigen::MatrixXd angles = 100 * Eigen::MatrixXd::Random(n_channels, n_samples), wrapped = angles;
+
+    Clock::time_point start = Clock::now();
+    for (Eigen::Index k = 0; k < wrapped.size(); ++k)
+        wrap2pi(wrapped.data()[k]);
+    printResult("scalar wrap2pi", wrapped.size() / secondsSince(start) / 1e6, "Msamples/s");
+    Eigen::MatrixXd bulk = angles;
+    start = Clock::now();
+    wrap2pi(bulk);
+    printResult("bulk wrap2pi", bulk.size() / secondsSince(start) / 1e6, "Msamples/s");
+
+    std::shared_ptr<const DiscreteRealization> filter = Builder::createSecondOrder(0.7, 10).getRealization();
+    Unwrapper unwrapper(n_channels);
+    Eigen::MatrixXd unwrapped, output;
+    start = Clock::now();
+    unwrapper.process(wrapped, unwrapped);
+    printResult("unwrap", wrapped.size() / secondsSince(start) / 1e6, "Msamples/s");
+
+    DoubleFilterBank bank(filter, n_channels);
+    unwrapper.reset();
+    start = Clock::now();
+    unwrapper.process(wrapped, unwrapped);
+    bank.process(unwrapped, output);
+    printResult("unwrap, then filter", wrapped.size() / secondsSince(start) / 1e6, "Msamples/s");
+
+    bank.reset();
+    unwrapper.reset();
+    Eigen::VectorXd sample(n_channels), y(n_channels);
+    start = Clock::now();
+    for (unsigned int k = 0; k < n_samples; ++k)
+    {
+        unwrapper.update(wrapped.col(k), sample);
+        bank.update(sample, y);
+    }
+    printResult("fused", wrapped.size() / secondsSince(start) / 1e6, "Msamples/s");
+}
+
+/*
+ * Polynomial toolkit: fixed-size division and roots, which stay on the stack, against the
+ * dynamic versions, and the continuous designs that substitute s in place.
+ */
+void benchmarkPolynomial()
+{
+    const unsigned int n = 100000;
+    std::cout << "[BENCHMARK] polynomial (" << n << " calls)" << std::endl;
+    const Eigen::Matrix<double, 5, 1> fixed_num(1, 0.5, 0.3, 0.2, 0.1), fixed_den(1, -2.5, 2.6, -1.3, 0.3);
+    const Eigen::VectorXd num = fixed_num, den = fixed_den;
+    double sink = 0;
+
+    Clock::time_point start = Clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        Eigen::Matrix<double, 5, 1> r = fixed_num, q;
+        r(4) += i;
+        polynomial::divide(r, fixed_den, q);
+        sink += r(4);
+    }
+    printResult("fixed-size divide", secondsSince(start) / n * 1e9, "ns/call");
+    Eigen::VectorXd q(5), r(5);
+    start = Clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        PolynomialDivision(num, den, q, r);
+        sink += r(4);
+    }
+    printResult("PolynomialDivision", secondsSince(start) / n * 1e9, "ns/call");
+
+    start = Clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+        sink += polynomial::roots(fixed_den)(0).real();
+    printResult("fixed-size roots", secondsSince(start) / n * 1e9, "ns/call");
+    start = Clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+        sink += PolynomialRoots(den)(0).real();
+    printResult("PolynomialRoots", secondsSince(start) / n * 1e9, "ns/call");
+
+    for (unsigned int order : {2, 8, 16})
+    {
+        Poly c_den = Poly::LinSpaced(order + 1, 1, 2), c_num = Poly::Ones(order);
+        const unsigned int designs = 20000 / order;
+        start = Clock::now();
+        for (unsigned int i = 0; i < designs; ++i)
+        {
+            DiscreteRealization design(c_num, c_den, 0.001, TUSTIN, 0, CONTROLLABLE_CANONICAL);
+            sink += design.getD();
+        }
+        std::ostringstream name;
+        name << "Tustin design, order " << order;
+        printResult(name.str(), secondsSince(start) / designs * 1e6, "us/design");
+    }
+    if (sink == 0.5)
+        std::cout << sink << std::endl;
+}
+
+/*
+ * A chain of second order filters, updated stage after stage against the single realization
+ * of their series interconnection, for a few filters and for many of them in parallel.
+ */
+void benchmarkInterconnection()
+{
+    const unsigned int n_stages = 4, n_samples = 20000;
+    std::cout << "[BENCHMARK] interconnection (" << n_stages << " second order stages, " << n_samples << " samples)" << std::endl;
+    std::vector<LinearSystem> stages;
+    for (unsigned int i = 0; i < n_stages; ++i)
+        stages.push_back(Builder::createSecondOrder(0.5 + 0.1 * i, 5 + 5 * i));
+    LinearSystem fused = stages[0];
+    for (unsigned int i = 1; i < n_stages; ++i)
+        fused = stages[i] * fused;
+    const Time dt = fused.getSamplingMicro();
+
+    for (unsigned int n_filters : {1, 1000})
+    {
+        for (LinearSystem &stage : stages)
+        {
+            stage.useNFilters(n_filters);
+            stage.setInitialTime(0);
+        }
+        fused.useNFilters(n_filters);
+        fused.setInitialTime(0);
+        const unsigned int n = n_samples / n_filters * 10;
+        Eigen::RowVectorXd u = Eigen::RowVectorXd::Ones(n_filters), y(n_filters);
+
+        Clock::time_point start = Clock::now();
+        for (unsigned int k = 1; k <= n; ++k)
+        {
+            y = u;
+            for (LinearSystem &stage : stages)
+                y = stage.update(y, k * dt).transpose();
+        }
+        std::ostringstream name;
+        name << n_filters << " filters, stage by stage";
+        printResult(name.str(), n * n_filters / secondsSince(start) / 1e6, "Msamples/s");
+
+        start = Clock::now();
+        for (unsigned int k = 1; k <= n; ++k)
+            y = fused.update(u, k * dt).transpose();
+        name.str("");
+        name << n_filters << " filters, fused";
+        printResult(name.str(), n * n_filters / secondsSince(start) / 1e6, "Msamples/s");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::map<std::string, void (*)()> benchmarks;
+    benchmarks["arena"] = &benchmarkArena;
+    benchmarks["frequency"] = &benchmarkFrequencyResponse;
+    benchmarks["decimator"] = &benchmarkDecimator;
+    benchmarks["batch"] = &benchmarkBatch;
+    benchmarks["sweep"] = &benchmarkSweep;
+    benchmarks["fixed"] = &benchmarkFixed;
+    benchmarks["precision"] = &benchmarkPrecision;
+    benchmarks["fixedpoint"] = &benchmarkFixedPoint;
+    benchmarks["forms"] = &benchmarkRealizationForms;
+    benchmarks["bank"] = &benchmarkCoefficientBank;
+    benchmarks["convolution"] = &benchmarkConvolution;
+    benchmarks["intime"] = &benchmarkParallelInTime;
+    benchmarks["filtfilt"] = &benchmarkFiltfilt;
+    benchmarks["variablestep"] = &benchmarkVariableStep;
+    benchmarks["perfevents"] = &benchmarkPerfEvents;
+    benchmarks["angles"] = &benchmarkAngles;
+    benchmarks["polynomial"] = &benchmarkPolynomial;
+    benchmarks["interconnection"] = &benchmarkInterconnection;
+
+    for (std::map<std::string, void (*)()>::iterator it = benchmarks.begin(); it != benchmarks.end(); ++it)
+    {
+        bool selected = (argc < 2);
+        for (int i = 1; i < argc; ++i)
+            selected |= (std::strcmp(argv[i], it->first.c_str()) == 0);
+        if (selected)
+            it->second();
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+import numpy as np
+import scipy.signal
+import time
+
+import sys
+sys.path.append('../build')
+from linear_system import LinearSystem, IntegrationMethod, filtfilt
+
+# Zero-phase filtering of large arrays, natively and with SciPy, on the same discrete filter
+N_CHANNELS = 64
+N_SAMPLES = 1000000
+ORDERS = [2, 4, 8]
+
+def timed(f, repeat=3):
+    best = float('inf')
+    for _ in range(repeat):
+        start = time.perf_counter()
+        result = f()
+        best = min(best, time.perf_counter() - start)
+    return best, result
+
+if __name__ == '__main__':
+    x = np.random.randn(N_CHANNELS, N_SAMPLES)
+    print("[BENCHMARK] filtfilt (%d channels, %d samples)" % (N_CHANNELS, N_SAMPLES))
+    for order in ORDERS:
+        b, a = scipy.signal.butter(order, 0.05)
+        sys_ = LinearSystem(b, a, 0.001, IntegrationMethod.DIRECT)
+        print(" order %d" % order)
+        t_scipy, y_scipy = timed(lambda: scipy.signal.filtfilt(b, a, x, axis=1))
+        print("  scipy: %.1f Msamples/s" % (x.size / t_scipy / 1e6))
+        for n_threads in [1, 4]:
+            t, y = timed(lambda: filtfilt(sys_, x, n_threads=n_threads))
+            print("  native, %d thread(s): %.1f Msamples/s (max difference %.2e)"
+                  % (n_threads, x.size / t / 1e6, np.abs(y - y_scipy).max()))
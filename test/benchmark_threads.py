@@ -0,0 +1,65 @@
+import numpy as np
+import asyncio, threading, time
+
+import sys
+sys.path.append('../build')
+from linear_system import Builder, ThreadPool
+
+# Each worker owns a bank of filters and feeds it blocks of samples, as an ingestion worker would
+N_FILTERS = 1000
+N_SAMPLES = 200
+N_BLOCKS = 20
+THREADS = [1, 2, 4, 8]
+
+def makeBanks(n):
+    damp = np.linspace(0.1, 2, N_FILTERS)
+    cutoff = np.full(N_FILTERS, 10.0)
+    return [Builder.createSecondOrderBank(damp, cutoff) for _ in range(n)]
+
+def runThreads(n_threads, data):
+    banks = makeBanks(n_threads)
+    def work(bank):
+        for _ in range(N_BLOCKS):
+            bank.process(data)
+    threads = [threading.Thread(target=work, args=(bank,)) for bank in banks]
+    start = time.perf_counter()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    return time.perf_counter() - start
+
+def runPool(n_threads, data):
+    banks = makeBanks(n_threads)
+    pool = ThreadPool(n_threads)
+    start = time.perf_counter()
+    for _ in range(N_BLOCKS):
+        pending = [pool.submitProcess(bank, data) for bank in banks]
+        for p in pending:
+            p.result()
+    return time.perf_counter() - start
+
+def runAsyncio(n_threads, data):
+    banks = makeBanks(n_threads)
+    pool = ThreadPool(n_threads)
+    async def work(bank):
+        for _ in range(N_BLOCKS):
+            await pool.submitProcess(bank, data)
+    async def main():
+        await asyncio.gather(*[work(bank) for bank in banks])
+    start = time.perf_counter()
+    asyncio.run(main())
+    return time.perf_counter() - start
+
+if __name__ == '__main__':
+    data = np.random.rand(N_FILTERS, N_SAMPLES)
+    print("[BENCHMARK] concurrent banks (%d filters, %d samples per block, %d blocks per worker)"
+          % (N_FILTERS, N_SAMPLES, N_BLOCKS))
+    for name, run in [("python threads", runThreads), ("thread pool", runPool), ("asyncio", runAsyncio)]:
+        print(" " + name)
+        base = None
+        for n in THREADS:
+            elapsed = run(n, data)
+            rate = n * N_BLOCKS * N_FILTERS * N_SAMPLES / elapsed / 1e6
+            base = base or rate
+            print("  %d threads: %.1f Msamples/s (speedup %.2f)" % (n, rate, rate / base))
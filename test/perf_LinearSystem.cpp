@@ -0,0 +1,498 @@
+/*
+ * Performance regression suite: runs representative workloads, then compares their throughput
+ * and heap allocation counts with the baseline stored in test/perf_baseline.json.
+ *
+ *   perf-library --baseline FILE            compare, exit with 1 on a regression
+ *   perf-library --baseline FILE --update   measure and store the cpp/ entries of FILE
+ *
+ * Throughputs are stored relative to a calibration loop, a plain bank of second-order filters
+ * that doesn't use the library, timed in processor time right before every repetition of every
+ * workload: the ratio cancels the speed of the machine and its drift during the run (frequency
+ * scaling, other loads), and the median over rounds of all the workloads discards the outliers.
+ * A run fails when a relative throughput falls below (1 - tolerance) times its baseline, the
+ * tolerance coming from the file or the PERF_TOLERANCE environment variable. Allocation counts
+ * are exact and fail as soon as they grow. A workload missing from the baseline, or a cpp/ entry
+ * of the baseline that is no longer measured, fails as well: refresh the baseline with --update
+ * when adding one.
+ */
+
+#include <Builder.hpp>
+#include <CoefficientBank.hpp>
+#include <FilterBank.hpp>
+#include <LinearSystem.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace linear_system;
+
+#ifdef __GLIBC__
+
+// Count every heap allocation, as test_Allocations.cpp does
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static std::atomic<long> heap_allocations(0);
+
+extern "C" void *malloc(size_t size)
+{
+    ++heap_allocations;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+    ++heap_allocations;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    ++heap_allocations;
+    return __libc_realloc(ptr, size);
+}
+
+#define COUNTS_ALLOCATIONS 1
+#else
+static long heap_allocations = 0;
+#define COUNTS_ALLOCATIONS 0
+#endif
+
+namespace
+{
+
+typedef std::map<std::string, double> Metrics;
+
+// Every relative throughput is the median of this many rounds over all the workloads, so that a
+// burst of noise spoils a single repetition of a workload rather than all of them
+const int rounds = 7;
+
+// Processor time rather than wall time, so that the time slices taken by other processes don't count
+double secondsSince(std::clock_t start)
+{
+    return double(std::clock() - start) / CLOCKS_PER_SEC;
+}
+
+struct Baseline
+{
+    double tolerance = 0.3;
+    Metrics throughput, allocations;
+};
+
+/*
+ * Reads the baseline, a JSON object with a number "tolerance" and two objects of numbers,
+ * "throughput" and "allocations". Only that shape is understood.
+ */
+class BaselineReader
+{
+private:
+    std::string text;
+    std::size_t pos = 0;
+
+    void skipSpaces()
+    {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+            ++pos;
+    }
+
+    void expect(char c)
+    {
+        skipSpaces();
+        if (pos >= text.size() || text[pos] != c)
+            throw std::runtime_error(std::string("malformed baseline, expected '") + c + "'");
+        ++pos;
+    }
+
+    bool accept(char c)
+    {
+        skipSpaces();
+        if (pos < text.size() && text[pos] == c)
+        {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    std::string string()
+    {
+        expect('"');
+        std::size_t end = text.find('"', pos);
+        if (end == std::string::npos)
+            throw std::runtime_error("malformed baseline, unterminated string");
+        std::string s = text.substr(pos, end - pos);
+        pos = end + 1;
+        return s;
+    }
+
+    double number()
+    {
+        skipSpaces();
+        const char *begin = text.c_str() + pos;
+        char *end;
+        double value = std::strtod(begin, &end);
+        if (end == begin)
+            throw std::runtime_error("malformed baseline, expected a number");
+        pos += end - begin;
+        return value;
+    }
+
+    Metrics object()
+    {
+        Metrics metrics;
+        expect('{');
+        if (accept('}'))
+            return metrics;
+        do
+        {
+            std::string key = string();
+            expect(':');
+            metrics[key] = number();
+        } while (accept(','));
+        expect('}');
+        return metrics;
+    }
+
+public:
+    explicit BaselineReader(const std::string &text) : text(text) {}
+
+    Baseline read()
+    {
+        Baseline baseline;
+        expect('{');
+        if (accept('}'))
+            return baseline;
+        do
+        {
+            std::string key = string();
+            expect(':');
+            if (key == "tolerance")
+                baseline.tolerance = number();
+            else if (key == "throughput")
+                baseline.throughput = object();
+            else if (key == "allocations")
+                baseline.allocations = object();
+            else
+                throw std::runtime_error("unknown baseline section \"" + key + "\"");
+        } while (accept(','));
+        expect('}');
+        return baseline;
+    }
+};
+
+void writeObject(std::ostream &out, const Metrics &metrics)
+{
+    out << "{";
+    for (Metrics::const_iterator it = metrics.begin(); it != metrics.end(); ++it)
+        out << (it == metrics.begin() ? "\n" : ",\n") << "    \"" << it->first << "\": " << it->second;
+    out << "\n  }";
+}
+
+void writeBaseline(const std::string &path, const Baseline &baseline)
+{
+    std::ofstream out(path);
+    out << std::setprecision(6);
+    out << "{\n  \"tolerance\": " << baseline.tolerance << ",\n  \"throughput\": ";
+    writeObject(out, baseline.throughput);
+    out << ",\n  \"allocations\": ";
+    writeObject(out, baseline.allocations);
+    out << "\n}\n";
+}
+
+/* Throughput of the calibration loop, in samples per second */
+double calibration()
+{
+    // A bank of second-order filters with their own coefficients, written without the library.
+    // Loops bound by throughput and memory track the speed of the workloads when the machine is
+    // shared, unlike a single dependency chain, which runs at the same speed either way.
+    const unsigned int n_filters = 4096, n_samples = 256;
+    static std::vector<double> b0(n_filters, 0.1), a1(n_filters, 1.9), a2(n_filters, -0.95),
+        x1(n_filters, 0), x2(n_filters, 0), u(n_filters, 1);
+    std::clock_t start = std::clock();
+    for (unsigned int k = 0; k < n_samples; ++k)
+    {
+        for (unsigned int i = 0; i < n_filters; ++i)
+        {
+            double y = b0[i] * u[i] + a1[i] * x1[i] + a2[i] * x2[i];
+            x2[i] = x1[i];
+            x1[i] = y;
+            u[i] = -u[i];
+        }
+    }
+    return double(n_filters) * n_samples / secondsSince(start);
+}
+
+/* Runs \p body, which processes \p work items, and returns its throughput relative to the calibration loop */
+template<typename Body>
+double throughput(double work, Body body)
+{
+    double reference = calibration();
+    std::clock_t start = std::clock();
+    body();
+    return work / secondsSince(start) / reference;
+}
+
+/* Returns the heap allocations made by \p body */
+template<typename Body>
+double allocations(Body body)
+{
+    long before = heap_allocations;
+    body();
+    return heap_allocations - before;
+}
+
+/* Returns how many throughputs fall below the tolerance of their baseline */
+int countRegressions(const Metrics &throughputs, const Baseline &baseline)
+{
+    int regressions = 0;
+    for (Metrics::const_iterator it = throughputs.begin(); it != throughputs.end(); ++it)
+    {
+        Metrics::const_iterator base = baseline.throughput.find(it->first);
+        regressions += base != baseline.throughput.end() && it->second < (1 - baseline.tolerance) * base->second;
+    }
+    return regressions;
+}
+
+/* Removes the cpp/ entries of \p metrics, which this suite measures */
+void eraseMeasured(Metrics &metrics)
+{
+    for (Metrics::iterator it = metrics.begin(); it != metrics.end();)
+        it = it->first.compare(0, 4, "cpp/") == 0 ? metrics.erase(it) : std::next(it);
+}
+
+/*
+ * Prints \p measured against \p baseline, with \p failed telling whether a value regressed, and
+ * returns the number of failures, including the workloads missing on either side
+ */
+template<typename Failed>
+int compare(const Metrics &measured, const Metrics &baseline, const char *unit, Failed failed)
+{
+    int regressions = 0;
+    for (Metrics::const_iterator it = measured.begin(); it != measured.end(); ++it)
+    {
+        Metrics::const_iterator base = baseline.find(it->first);
+        bool missing = base == baseline.end();
+        bool regressed = missing || failed(it->second, base->second);
+        regressions += regressed;
+        std::cout << (regressed ? "FAIL " : "ok   ") << std::setw(32) << it->first << std::setw(10) << it->second
+                  << unit;
+        if (missing)
+            std::cout << " (missing from the baseline)";
+        else
+            std::cout << " (baseline " << base->second << ")";
+        std::cout << std::endl;
+    }
+    for (Metrics::const_iterator it = baseline.begin(); it != baseline.end(); ++it)
+    {
+        if (it->first.compare(0, 4, "cpp/") == 0 && measured.find(it->first) == measured.end())
+        {
+            ++regressions;
+            std::cout << "FAIL " << std::setw(32) << it->first << "no longer measured" << std::endl;
+        }
+    }
+    return regressions;
+}
+
+void singleFilter(Metrics &throughputs, Metrics &counts)
+{
+    const unsigned int n_samples = 1 << 18;
+    LinearSystem sys = Builder::createSecondOrder(0.7, 10);
+    sys.setInitialTime(0);
+    Input u = Input::Constant(1, 1);
+    Output y(1);
+    Time time = 0;
+    auto run = [&]() {
+        for (unsigned int k = 0; k < n_samples; ++k)
+        {
+            time += sys.getSamplingMicro();
+            sys.update(u, time, y);
+            // feeding the output back keeps the samples dependent, and away from subnormals
+            u(0) = 1 - y(0);
+        }
+    };
+    throughputs["cpp/single_filter"] = throughput(n_samples, run);
+    counts["cpp/single_filter"] = allocations(run);
+}
+
+void banks(Metrics &throughputs, Metrics &counts)
+{
+    const unsigned int n_filters = 10000, n_samples = 500;
+    Eigen::VectorXd u = Eigen::VectorXd::Random(n_filters), y(n_filters);
+
+    CoefficientBank bank = Builder::createSecondOrderBank(Eigen::VectorXd::LinSpaced(n_filters, 0.1, 2),
+        Eigen::VectorXd::Constant(n_filters, 10));
+    auto run_bank = [&]() {
+        for (unsigned int k = 0; k < n_samples; ++k)
+            bank.update(u, y);
+    };
+    throughputs["cpp/coefficient_bank_10k"] = throughput(n_filters * n_samples, run_bank);
+    counts["cpp/coefficient_bank_10k"] = allocations(run_bank);
+
+    DoubleFilterBank same(Builder::createSecondOrder(0.7, 10).getRealization(), n_filters);
+    auto run_same = [&]() {
+        for (unsigned int k = 0; k < n_samples; ++k)
+            same.update(u, y);
+    };
+    throughputs["cpp/filter_bank_10k"] = throughput(n_filters * n_samples, run_same);
+    counts["cpp/filter_bank_10k"] = allocations(run_same);
+}
+
+void discretization(Metrics &throughputs, Metrics &counts)
+{
+    for (unsigned int order = 1; order <= 20; ++order)
+    {
+        // Roughly constant time per order, several milliseconds
+        const unsigned int n_designs = 40000 / order;
+        // Poles spread over a decade, so that every order is well conditioned
+        Poly den = Poly::Constant(1, 1);
+        for (unsigned int k = 0; k < order; ++k)
+        {
+            double pole = 2 * M_PI * (1 + 9.0 * k / std::max(order - 1, 1u));
+            Poly next = Poly::Zero(den.size() + 1);
+            next.head(den.size()) = den;
+            next.tail(den.size()) += pole * den;
+            den = next;
+        }
+        Poly num = Poly::Zero(order + 1);
+        num(order) = den(order);
+
+        std::ostringstream name;
+        name << "cpp/discretize_order_" << std::setw(2) << std::setfill('0') << order;
+        auto run = [&]() {
+            for (unsigned int k = 0; k < n_designs; ++k)
+                DiscreteRealization realization(num, den, 0.001, TUSTIN, 0);
+        };
+        throughputs[name.str()] = throughput(n_designs, run);
+        counts[name.str()] = allocations([&]() {DiscreteRealization realization(num, den, 0.001, TUSTIN, 0);});
+    }
+}
+
+/* Runs every workload for a number of rounds, and keeps the median of each relative throughput */
+void measure(Metrics &throughputs, Metrics &counts)
+{
+    std::map<std::string, std::vector<double>> ratios;
+    for (int round = 0; round < rounds; ++round)
+    {
+        Metrics measured;
+        singleFilter(measured, counts);
+        banks(measured, counts);
+        discretization(measured, counts);
+        for (Metrics::const_iterator it = measured.begin(); it != measured.end(); ++it)
+            ratios[it->first].push_back(it->second);
+    }
+    for (auto &it : ratios)
+    {
+        std::nth_element(it.second.begin(), it.second.begin() + rounds / 2, it.second.end());
+        throughputs[it.first] = it.second[rounds / 2];
+    }
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    std::string path;
+    bool update = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+            path = argv[++i];
+        else if (std::strcmp(argv[i], "--update") == 0)
+            update = true;
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " --baseline FILE [--update]" << std::endl;
+            return 2;
+        }
+    }
+    if (path.empty())
+    {
+        std::cerr << "usage: " << argv[0] << " --baseline FILE [--update]" << std::endl;
+        return 2;
+    }
+
+    Baseline baseline;
+    std::ifstream in(path);
+    if (in)
+    {
+        std::stringstream text;
+        text << in.rdbuf();
+        try
+        {
+            baseline = BaselineReader(text.str()).read();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << path << ": " << e.what() << std::endl;
+            return 2;
+        }
+    }
+    else if (!update)
+    {
+        std::cerr << "cannot read " << path << ", create it with --update" << std::endl;
+        return 2;
+    }
+    if (const char *tolerance = std::getenv("PERF_TOLERANCE"))
+        baseline.tolerance = std::atof(tolerance);
+
+    // A new baseline keeps the slowest of a few measurements, and a comparison measures again
+    // while some throughput falls short, keeping the fastest: a real regression persists, noise
+    // between runs should neither raise the baseline nor fail the comparison
+    Metrics throughputs, counts;
+    for (int run = 0; run < 3; ++run)
+    {
+        Metrics measured;
+        measure(measured, counts);
+        for (Metrics::const_iterator it = measured.begin(); it != measured.end(); ++it)
+        {
+            Metrics::iterator kept = throughputs.find(it->first);
+            if (kept == throughputs.end() || (update ? it->second < kept->second : it->second > kept->second))
+                throughputs[it->first] = it->second;
+        }
+        if (!update && countRegressions(throughputs, baseline) == 0)
+            break;
+    }
+    if (!COUNTS_ALLOCATIONS)
+    {
+        counts.clear();
+        eraseMeasured(baseline.allocations);
+    }
+
+    if (update)
+    {
+        eraseMeasured(baseline.throughput);
+        eraseMeasured(baseline.allocations);
+        for (Metrics::const_iterator it = throughputs.begin(); it != throughputs.end(); ++it)
+            baseline.throughput[it->first] = it->second;
+        for (Metrics::const_iterator it = counts.begin(); it != counts.end(); ++it)
+            baseline.allocations[it->first] = it->second;
+        writeBaseline(path, baseline);
+        std::cout << "updated " << path << std::endl;
+        return 0;
+    }
+
+    // Throughputs are relative to the calibration loop: samples, or designs, per calibration sample
+    std::cout << std::left << std::setprecision(4);
+    const double tolerance = baseline.tolerance;
+    int regressions = compare(throughputs, baseline.throughput, "",
+                              [tolerance](double value, double base) {return value < (1 - tolerance) * base;});
+    regressions += compare(counts, baseline.allocations, " allocations",
+                           [](double value, double base) {return value > base;});
+
+    if (regressions > 0)
+        std::cout << regressions << " regressions against " << path << std::endl;
+    return regressions > 0;
+}
@@ -0,0 +1,164 @@
+"""Performance regression suite of the Python bindings, the counterpart of perf_LinearSystem.cpp.
+
+    python3 perf_LinearSystem.py --baseline FILE            compare, exit with 1 on a regression
+    python3 perf_LinearSystem.py --baseline FILE --update   measure and store the python/ entries
+
+As in perf_LinearSystem.cpp, throughputs are relative to a calibration loop, here a second-order
+recursion in plain Python timed right before every repetition, in processor time; each one is
+the median of a few rounds over all the workloads. A run fails when one falls below
+(1 - tolerance) times its baseline, the tolerance coming from the file or the PERF_TOLERANCE
+environment variable.
+
+The allocation entries are the kilobytes that each call of a workload leaves allocated, traced
+with tracemalloc: anything but 0 is a leak of the bindings, such as an output that is never
+freed. A workload missing from the baseline, or a python/ entry of the baseline that is no longer
+measured, fails as well: refresh the baseline with --update when adding one. The python/ entries
+are only recorded by running --update against the built bindings, never written by hand; until
+then the comparison fails and says so.
+"""
+import numpy as np
+import argparse, gc, json, os, statistics, time, tracemalloc
+
+import sys
+sys.path.append('../build')
+from linear_system import Builder
+
+ROUNDS = 7
+
+def calibration():
+    n = 100000
+    y1 = y2 = 0.0
+    sign = 1.0
+    start = time.process_time()
+    for _ in range(n):
+        y1, y2 = 1.9 * y1 - 0.95 * y2 + sign, y1
+        sign = -sign
+    return n / (time.process_time() - start)
+
+def throughput(work, body):
+    """Throughput of body, which processes work items, relative to the calibration loop"""
+    reference = calibration()
+    start = time.process_time()
+    body()
+    return work / (time.process_time() - start) / reference
+
+def retained(body, calls=5):
+    """Kilobytes that each call of body leaves allocated, once warmed up"""
+    body()
+    gc.collect()
+    tracemalloc.start()
+    try:
+        before = tracemalloc.get_traced_memory()[0]
+        for _ in range(calls):
+            body()
+        gc.collect()
+        after = tracemalloc.get_traced_memory()[0]
+    finally:
+        tracemalloc.stop()
+    return max(0, (after - before) // (1024 * calls))
+
+def workloads():
+    """Returns the workloads, as a dictionary from their names to (work, body)"""
+    # per-sample updates pay the binding overhead on every sample, batches only once
+    n_samples = 20000
+    filt = Builder.createSecondOrder(0.7, 10)
+    filt.setInitialTime(0)
+    step = int(round(filt.getSampling() * 1e6))
+    now = 0
+    u = np.ones(1)
+    def perSample():
+        nonlocal now
+        for _ in range(n_samples):
+            now += step
+            filt.update(u, now)
+
+    data = np.random.rand(n_samples, 1)
+    def batch():
+        nonlocal now
+        filt.process(data, now + step)
+        now += n_samples * step
+
+    n_filters, n_block = 10000, 100
+    bank = Builder.createSecondOrderBank(np.linspace(0.1, 2, n_filters), np.full(n_filters, 10.0))
+    block = np.random.rand(n_filters, n_block)
+    return {"python/per_sample": (n_samples, perSample),
+            "python/batch": (n_samples, batch),
+            "python/coefficient_bank_10k": (n_filters * n_block, lambda: bank.process(block))}
+
+def measure():
+    """Returns the median relative throughputs over a few rounds, and the retained kilobytes"""
+    ratios, counts = {}, {}
+    for _ in range(ROUNDS):
+        for name, (work, body) in workloads().items():
+            ratios.setdefault(name, []).append(throughput(work, body))
+    for name, (work, body) in workloads().items():
+        counts[name] = retained(body)
+    return {name: statistics.median(values) for name, values in ratios.items()}, counts
+
+def compare(measured, baseline, unit, failed):
+    """Prints measured against baseline and returns the names of the failures, including the
+    workloads missing on either side"""
+    failures = []
+    for name, value in sorted(measured.items()):
+        base = baseline.get(name)
+        if base is None or failed(value, base):
+            failures.append(name)
+        print("%s %-32s%-10.4g%s%s" % ("FAIL" if name in failures else "ok  ", name, value, unit,
+                                       " (missing from the baseline)" if base is None else " (baseline %.4g)" % base))
+    for name in sorted(baseline):
+        if name.startswith("python/") and name not in measured:
+            failures.append(name)
+            print("FAIL %-32sno longer measured" % name)
+    return failures
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--baseline", required=True)
+    parser.add_argument("--update", action="store_true")
+    args = parser.parse_args()
+
+    baseline = {"tolerance": 0.3, "throughput": {}, "allocations": {}}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline.update(json.load(f))
+    elif not args.update:
+        print("cannot read %s, create it with --update" % args.baseline)
+        return 2
+    tolerance = float(os.environ.get("PERF_TOLERANCE", baseline["tolerance"]))
+    if not args.update and not any(name.startswith("python/") for name in baseline["throughput"]):
+        print("%s has no python/ entries, record them with --update" % args.baseline)
+        return 1
+
+    # as in perf_LinearSystem.cpp, a new baseline keeps the slowest of a few measurements and a
+    # comparison measures again while some throughput falls short, keeping the fastest
+    def shortfalls(results):
+        return [name for name, value in results.items()
+                if name in baseline["throughput"] and value < (1 - tolerance) * baseline["throughput"][name]]
+    results = {}
+    for _ in range(3):
+        keep = min if args.update else max
+        measured, counts = measure()
+        for name, value in measured.items():
+            results[name] = keep(value, results.get(name, value))
+        if not args.update and not shortfalls(results):
+            break
+
+    if args.update:
+        for section, values in (("throughput", results), ("allocations", counts)):
+            baseline[section] = {name: value for name, value in baseline[section].items()
+                                 if not name.startswith("python/")}
+            baseline[section].update(values)
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("updated %s" % args.baseline)
+        return 0
+
+    failed = compare(results, baseline["throughput"], "", lambda value, base: value < (1 - tolerance) * base)
+    failed += compare(counts, baseline["allocations"], " kB retained per call", lambda value, base: value > base)
+    if failed:
+        print("%d regressions against %s" % (len(failed), args.baseline))
+    return 1 if failed else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
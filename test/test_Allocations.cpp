@@ -0,0 +1,102 @@
+#include <boost/test/unit_test.hpp>
+#include <iostream>
+#include <atomic>
+#include <cstddef>
+#include <Builder.hpp>
+#include <LinearSystem.hpp>
+
+using namespace linear_system;
+
+#ifdef __GLIBC__
+
+// Count every heap allocation made by this process (Eigen and operator new both end up in
+// malloc) by interposing the C allocation functions and forwarding to glibc.
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static std::atomic<long> heap_allocations(0);
+
+extern "C" void *malloc(size_t size)
+{
+    ++heap_allocations;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+    ++heap_allocations;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    ++heap_allocations;
+    return __libc_realloc(ptr, size);
+}
+
+BOOST_AUTO_TEST_SUITE(allocations)
+
+BOOST_AUTO_TEST_CASE(test_steady_state_allocations)
+{
+    std::cout << "[TEST] no heap allocations in steady state" << std::endl;
+    LinearSystem sys = Builder::createSecondOrder(0.7, 5);
+    LinearSystem ref = Builder::createReferenceFilter2I(4, 2, 1);
+    sys.useNFilters(3);
+    ref.useNFilters(3);
+    sys.setInitialTime(0);
+    ref.setInitialTime(0);
+
+    Input u(3);
+    u << 1, -2, 0.5;
+    Output y(3), y_ref(3);
+    Eigen::MatrixXd state(3, sys.getOrder());
+    Eigen::VectorXd num, den;
+
+    // warm up, so that lazily created buffers exist before counting
+    Time time = sys.getSamplingMicro();
+    sys.update(u, time, y);
+    ref.update(u, time, y_ref);
+    sys.getCoefficients(num, den);
+
+    long before = heap_allocations;
+    for (int k = 0; k < 1000; ++k)
+    {
+        time += sys.getSamplingMicro();
+        sys.update(u, time, y);
+        ref.update(u, time, y_ref);
+        sys.getState(state);
+        sys.setState(state);
+        sys.getCoefficients(num, den);
+        u(0) = sys.getOutput()(1);
+    }
+    // catching up several samples at once
+    time += 5 * sys.getSamplingMicro();
+    sys.update(u, time, y);
+    long allocations = heap_allocations - before;
+
+    BOOST_CHECK_EQUAL(allocations, 0);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_move_only_allocations)
+{
+    std::cout << "[TEST] moving states does not copy them" << std::endl;
+    LinearSystem sys = Builder::createSecondOrder(0.7, 5);
+    sys.useNFilters(100);
+    Eigen::MatrixXd state = Eigen::MatrixXd::Ones(100, sys.getOrder());
+    FilterState fstate = sys.getFilterState();
+
+    long before = heap_allocations;
+    sys.setState(state);
+    sys.setFilterState(std::move(fstate));
+    LinearSystem moved(std::move(sys));
+    long allocations = heap_allocations - before;
+
+    BOOST_CHECK_EQUAL(allocations, 0);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
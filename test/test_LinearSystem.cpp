@@ -6,6 +6,25 @@
 #include <yaml-cpp/yaml.h>
 #include <HelperFunctions.hpp>
 #include <LinearSystem.hpp>
+#include <DesignCache.hpp>
+#include <FilterArena.hpp>
+#include <FrequencyResponse.hpp>
+#include <Builder.hpp>
+#include <MIMORealization.hpp>
+#include <BatchSimulation.hpp>
+#include <ParameterSweep.hpp>
+#include <FixedFilter.hpp>
+#include <FilterBank.hpp>
+#include <FixedPoint.hpp>
+#include <CoefficientBank.hpp>
+#include <ThreadPool.hpp>
+#include <ConvolutionEngine.hpp>
+#include <ZeroPhase.hpp>
+#include <VariableStep.hpp>
+#include <PerfEvents.hpp>
+#include <Unwrap.hpp>
+#include <Polynomial.hpp>
+#include <Interconnection.hpp>
 #include <limits>
 #include <fstream>
 
@@ -372,3 +391,1237 @@ BOOST_AUTO_TEST_CASE(test_sampling_time)
         }
     }
 }
+
+BOOST_AUTO_TEST_CASE(test_design_cache)
+{
+    std::cout << "[TEST] design cache" << std::endl;
+    DesignCache &cache = DesignCache::instance();
+    cache.clear();
+
+    Poly num(2), den(3);
+    num << 1, 1;
+    den << 2, 4, 2;
+
+    LinearSystem a(num, den, 0.01, TUSTIN, 3);
+    LinearSystem b(num / 2, den / 2, 0.01, TUSTIN, 3);
+    LinearSystem c(num, den, 0.01, BACKWARD_EULER, 3);
+    LinearSystem d(num, den, 0.02, BACKWARD_EULER);
+
+    BOOST_CHECK(a.getRealization() == b.getRealization());
+    BOOST_CHECK(a.getRealization() != c.getRealization());
+    BOOST_CHECK(c.getRealization() != d.getRealization());
+    BOOST_CHECK_EQUAL(cache.getMisses(), 3u);
+    BOOST_CHECK_EQUAL(cache.getHits(), 1u);
+    BOOST_CHECK_EQUAL(cache.size(), 3u);
+
+    // the prewarp frequency is meaningless without Tustin, so it must not split designs
+    LinearSystem e(num, den, 0.01, BACKWARD_EULER);
+    BOOST_CHECK(c.getRealization() == e.getRealization());
+    LinearSystem f(num, den, 0.01, BACKWARD_EULER, -1);
+    BOOST_CHECK(c.getRealization() == f.getRealization());
+    BOOST_CHECK_THROW(LinearSystem(num, den, 0.01, TUSTIN, -1), std::invalid_argument);
+
+    // a cached design must match a freshly computed one
+    DiscreteRealization fresh(num, den, 0.01, TUSTIN, 3);
+    Poly tf_num, tf_den;
+    a.getCoefficients(tf_num, tf_den);
+    BOOST_CHECK_SMALL((tf_num - fresh.getNumerator()).cwiseAbs().maxCoeff(), 1e-15);
+    BOOST_CHECK_SMALL((tf_den - fresh.getDenominator()).cwiseAbs().maxCoeff(), 1e-15);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_shared_realization)
+{
+    std::cout << "[TEST] shared realization with independent states" << std::endl;
+    Poly num(1), den(3);
+    num << 1;
+    den << 1, 1.4, 1;
+    std::shared_ptr<const DiscreteRealization> realization =
+        std::make_shared<const DiscreteRealization>(num, den, 0.01, TUSTIN, 0);
+
+    LinearSystem a(realization);
+    a.setInitialTime(0);
+    LinearSystem b = a;
+    BOOST_CHECK(a.getRealization() == b.getRealization());
+
+    Eigen::VectorXd u(1);
+    u << 1;
+    for (Time t = 10000; t <= 500000; t += 10000)
+        a.update(u, t);
+
+    // b did not move
+    BOOST_CHECK_EQUAL(b.getState().cwiseAbs().maxCoeff(), 0);
+
+    // copying the state over makes both filters evolve identically
+    b.setFilterState(a.getFilterState());
+    for (Time t = 510000; t <= 1000000; t += 10000)
+        BOOST_CHECK_EQUAL((a.update(u, t) - b.update(u, t)).cwiseAbs().maxCoeff(), 0);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_filter_arena)
+{
+    std::cout << "[TEST] filters stored in an arena" << std::endl;
+    Poly num(1), den(3);
+    num << 1;
+    den << 1, 1.4, 1;
+    std::shared_ptr<const DiscreteRealization> realization =
+        std::make_shared<const DiscreteRealization>(num, den, 0.01, TUSTIN, 0);
+
+    FilterArena arena(4096);
+    LinearSystem heap(realization);
+    LinearSystem a(realization, arena), b(realization, arena);
+    a.useNFilters(3);
+    b.useNFilters(3);
+    heap.useNFilters(3);
+
+    const double *a_data = a.getFilterState().state.data();
+    const double *b_data = b.getFilterState().state.data();
+    BOOST_CHECK(a.getFilterState().getArena() == &arena);
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(a_data) % FilterArena::alignment, 0u);
+    BOOST_CHECK(b_data > a_data && (b_data - a_data) * sizeof(double) < arena.getUsed());
+    BOOST_CHECK(arena.getUsed() <= 4 * FilterArena::alignment);
+
+    // a copy moves to the heap and runs just like the original
+    LinearSystem c = a;
+    BOOST_CHECK(c.getFilterState().getArena() == nullptr);
+
+    Eigen::VectorXd u(3);
+    u << 1, 2, 3;
+    a.setInitialTime(0);
+    c.setInitialTime(0);
+    heap.setInitialTime(0);
+    for (Time t = 10000; t <= 200000; t += 10000)
+    {
+        Output y = heap.update(u, t);
+        BOOST_CHECK_EQUAL((a.update(u, t) - y).cwiseAbs().maxCoeff(), 0);
+        BOOST_CHECK_EQUAL((c.update(u, t) - y).cwiseAbs().maxCoeff(), 0);
+    }
+
+    // the output is returned as a vector, whose copies do not follow the arena storage
+    auto saved = a.getOutput();
+    Output expected = saved;
+    a.update(u, 210000);
+    BOOST_CHECK_EQUAL((saved - expected).cwiseAbs().maxCoeff(), 0);
+    BOOST_CHECK((a.getOutput() - expected).cwiseAbs().maxCoeff() > 0);
+
+    // banks store their states in an arena too, and their copies on the heap
+    FilterArena bank_arena(4096);
+    MixedFilterBank mixed(realization, 3, bank_arena), mixed_heap(realization, 3);
+    CoefficientBank coefficients(std::vector<std::shared_ptr<const DiscreteRealization> >(3, realization), bank_arena);
+    CoefficientBank coefficients_heap = coefficients;
+    BOOST_CHECK(mixed.getArena() == &bank_arena && coefficients.getArena() == &bank_arena);
+    BOOST_CHECK(mixed_heap.getArena() == nullptr && coefficients_heap.getArena() == nullptr);
+    BOOST_CHECK(bank_arena.getUsed() > 0);
+
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(3, 50), output, output_heap;
+    coefficients.process(input, output);
+    coefficients_heap.process(input, output_heap);
+    BOOST_CHECK_EQUAL((output - output_heap).cwiseAbs().maxCoeff(), 0);
+    BOOST_CHECK_EQUAL((coefficients.getState() - coefficients_heap.getState()).cwiseAbs().maxCoeff(), 0);
+    MixedFilterBank::Matrix mixed_output, mixed_heap_output;
+    mixed.process(input.cast<float>(), mixed_output);
+    mixed_heap.process(input.cast<float>(), mixed_heap_output);
+    BOOST_CHECK_EQUAL((mixed_output - mixed_heap_output).cwiseAbs().maxCoeff(), 0);
+
+    // growing past the arena capacity must fail loudly
+    BOOST_CHECK_THROW(b.useNFilters(1000), std::bad_alloc);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_frequency_response)
+{
+    std::cout << "[TEST] frequency response" << std::endl;
+    Poly num(2), den(4);
+    num << 2, 3;
+    den << 1, 2.2, 3.1, 0.7;
+    double ts = 0.01;
+    std::shared_ptr<const DiscreteRealization> realization =
+        std::make_shared<const DiscreteRealization>(num, den, ts, TUSTIN, 0);
+
+    Eigen::VectorXd omega = Eigen::VectorXd::LinSpaced(1000, 0, 300);
+    Eigen::VectorXcd h_cont = continuousResponse(*realization, omega);
+    Eigen::VectorXcd h_disc = discreteResponse(*realization, omega, 3);
+
+    const Eigen::MatrixXd &A = realization->getA();
+    Eigen::MatrixXcd I = Eigen::MatrixXcd::Identity(A.rows(), A.cols());
+    double max_error_cont = 0, max_error_disc = 0;
+    for (int i = 0; i < omega.size(); ++i)
+    {
+        std::complex<double> s(0, omega(i));
+        std::complex<double> expected = (2. * s + 3.) / (((s + 2.2) * s + 3.1) * s + 0.7);
+        max_error_cont = std::max(max_error_cont, std::abs(h_cont(i) - expected));
+
+        // H(z) = C (zI - A)^-1 B + D
+        std::complex<double> z = std::exp(s * ts);
+        Eigen::VectorXcd x = (z * I - A.cast<std::complex<double> >()).lu().solve(realization->getB().cast<std::complex<double> >());
+        expected = (realization->getC().cast<std::complex<double> >() * x)(0) + realization->getD();
+        max_error_disc = std::max(max_error_disc, std::abs(h_disc(i) - expected));
+    }
+    BOOST_CHECK_SMALL(max_error_cont, 1e-12);
+    BOOST_CHECK_SMALL(max_error_disc, 1e-9);
+
+    // Tustin maps the DC gain exactly
+    BOOST_CHECK_SMALL(std::abs(h_disc(0) - h_cont(0)), 1e-7);
+
+    // the multi-filter variant stacks the individual responses
+    std::vector<std::shared_ptr<const DiscreteRealization> > bank(5, realization);
+    Eigen::MatrixXcd h_bank = discreteResponse(bank, omega, 2);
+    BOOST_CHECK_EQUAL(h_bank.cols(), 5);
+    BOOST_CHECK_SMALL((h_bank.col(4) - h_disc).cwiseAbs().maxCoeff(), 1e-15);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_exact_discretization)
+{
+    std::cout << "[TEST] ZOH, FOH and impulse-invariant discretization" << std::endl;
+    // H(s) = wn^2 / (s^2 + 2 damp wn s + wn^2), sampled far below the usual 10x oversampling
+    double damp = 0.3, wn = 20, ts = 0.05;
+    Poly num(1), den(3);
+    num << wn*wn;
+    den << 1, 2*damp*wn, wn*wn;
+    double wd = wn * std::sqrt(1 - damp*damp), phi = std::acos(damp);
+
+    // ZOH reproduces the continuous step response exactly at the sampling instants
+    LinearSystem zoh(num, den, ts, ZOH);
+    zoh.setInitialTime(0);
+    Eigen::VectorXd u(1);
+    u << 1;
+    double max_error = 0;
+    for (int k = 1; k <= 40; ++k)
+    {
+        // the output returned at step k is y[k-1]
+        double t = (k - 1) * ts;
+        double expected = 1 - std::exp(-damp*wn*t) * std::sin(wd*t + phi) / std::sqrt(1 - damp*damp);
+        max_error = std::max(max_error, std::abs(zoh.update(u, LinearSystem::getTimeFromSeconds(k * ts))(0) - expected));
+    }
+    BOOST_CHECK_SMALL(max_error, 1e-12);
+
+    // FOH reproduces the continuous response to a ramp exactly at the sampling instants
+    LinearSystem foh(num, den, ts, FOH);
+    foh.setInitialTime(0);
+    max_error = 0;
+    for (int k = 1; k <= 40; ++k)
+    {
+        double t = (k - 1) * ts;
+        u << t;
+        // ramp response of the second-order system
+        double expected = t - 2*damp/wn + std::exp(-damp*wn*t) / wd * std::sin(wd*t + 2*phi);
+        max_error = std::max(max_error, std::abs(foh.update(u, LinearSystem::getTimeFromSeconds(k * ts))(0) - expected));
+    }
+    BOOST_CHECK_SMALL(max_error, 1e-12);
+
+    // impulse invariance samples the impulse response: h[k] = Ts h(k Ts)
+    LinearSystem imp(num, den, ts, IMPULSE_INVARIANT);
+    imp.setInitialTime(0);
+    max_error = 0;
+    for (int k = 1; k <= 40; ++k)
+    {
+        double t = (k - 1) * ts;
+        u << ((k == 1) ? 1 : 0);
+        double expected = ts * wn*wn / wd * std::exp(-damp*wn*t) * std::sin(wd*t);
+        max_error = std::max(max_error, std::abs(imp.update(u, LinearSystem::getTimeFromSeconds(k * ts))(0) - expected));
+    }
+    BOOST_CHECK_SMALL(max_error, 1e-12);
+
+    // the discrete transfer function matches the realization
+    Eigen::VectorXd omega = Eigen::VectorXd::LinSpaced(50, 0, 50);
+    const DiscreteRealization &ss = *zoh.getRealization();
+    Eigen::VectorXcd h = discreteResponse(ss, omega);
+    Eigen::MatrixXcd I = Eigen::MatrixXcd::Identity(2, 2);
+    for (int i = 0; i < omega.size(); ++i)
+    {
+        std::complex<double> z = std::exp(std::complex<double>(0, omega(i) * ts));
+        Eigen::VectorXcd x = (z * I - ss.getA().cast<std::complex<double> >()).lu().solve(ss.getB().cast<std::complex<double> >());
+        std::complex<double> expected = (ss.getC().cast<std::complex<double> >() * x)(0) + ss.getD();
+        BOOST_CHECK_SMALL(std::abs(h(i) - expected), 1e-10);
+    }
+
+    BOOST_CHECK_THROW(LinearSystem(den, den, ts, IMPULSE_INVARIANT), std::logic_error);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_decimator)
+{
+    std::cout << "[TEST] decimating filters" << std::endl;
+    const unsigned int factor = 8, n = 203;
+    double ts = 1.0 / 8000;
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(2, n);
+
+    // the decimated outputs are the full-rate outputs at every M-th sample
+    Decimator decimator = Builder::createDecimator(factor, ts);
+    BOOST_CHECK(!decimator.isPolyphase());
+    LinearSystem full(decimator.getRealization());
+    full.useNFilters(2);
+    full.setInitialTime(0);
+    Decimator dec2(decimator.getRealization(), factor, 2);
+    Eigen::MatrixXd output;
+    unsigned int n_outputs = dec2.process(input.leftCols(100), output);
+    Eigen::MatrixXd rest;
+    n_outputs += dec2.process(input.rightCols(n - 100), rest);
+    BOOST_CHECK_EQUAL(n_outputs, (n + factor - 1) / factor);
+    BOOST_CHECK_EQUAL(output.cols() + rest.cols(), n_outputs);
+
+    Eigen::MatrixXd decimated(2, n_outputs);
+    decimated << output, rest;
+    for (unsigned int k = 0; k < n; ++k)
+    {
+        Output y = full.update(input.col(k).transpose(), LinearSystem::getTimeFromSeconds((k + 1) * ts) + 1);
+        if (k % factor == 0)
+            BOOST_CHECK_SMALL((decimated.col(k / factor) - y).cwiseAbs().maxCoeff(), 1e-12);
+    }
+
+    // the moving average runs on the FIR path
+    Decimator average = Builder::createMovingAverageDecimator(factor, ts);
+    BOOST_CHECK(average.isPolyphase());
+    BOOST_CHECK_CLOSE(average.getOutputSampling(), factor * ts, 1e-9);
+    Eigen::VectorXd u(1);
+    for (unsigned int k = 0; k < n; ++k)
+    {
+        u << input(0, k);
+        if (average.update(u.transpose()))
+        {
+            unsigned int first = (k + 1 >= factor) ? k + 1 - factor : 0;
+            double expected = input.row(0).segment(first, k + 1 - first).sum() / factor;
+            BOOST_CHECK_SMALL(average.getOutput()(0) - expected, 1e-12);
+        }
+    }
+
+    // and matches the state-space recursion of the same filter
+    LinearSystem fir(average.getRealization());
+    fir.setInitialTime(0);
+    average.reset();
+    for (unsigned int k = 0; k < n; ++k)
+    {
+        u << input(1, k);
+        Output y = fir.update(u.transpose(), LinearSystem::getTimeFromSeconds((k + 1) * ts) + 1);
+        if (average.update(u.transpose()))
+            BOOST_CHECK_SMALL(average.getOutput()(0) - y(0), 1e-12);
+    }
+
+    // a copy of the output does not change with the next one
+    auto saved = average.getOutput();
+    Output expected = saved;
+    u << expected(0) + 1;
+    for (unsigned int k = 0; k < factor; ++k)
+        average.update(u.transpose());
+    BOOST_CHECK_EQUAL(saved(0), expected(0));
+    BOOST_CHECK(average.getOutput()(0) != expected(0));
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_mimo)
+{
+    std::cout << "[TEST] MIMO state-space systems" << std::endl;
+    // y1 = H1 u1 + H2 u2, y2 = H3 u1, built from the continuous SISO realizations
+    Poly num[3], den[3];
+    num[0].resize(2); den[0].resize(3);
+    num[1].resize(1); den[1].resize(2);
+    num[2].resize(3); den[2].resize(3);
+    num[0] << 1, 2;    den[0] << 1, 3, 2;
+    num[1] << 4;       den[1] << 1, 5;
+    num[2] << 2, 1, 3; den[2] << 1, 0.4, 9;
+
+    Eigen::MatrixXd A = Eigen::MatrixXd::Zero(5, 5), B = Eigen::MatrixXd::Zero(5, 2);
+    Eigen::MatrixXd C = Eigen::MatrixXd::Zero(2, 5), D = Eigen::MatrixXd::Zero(2, 2);
+    const int offset[] = {0, 2, 3}, input[] = {0, 1, 0}, output[] = {0, 0, 1};
+    for (int k = 0; k < 3; ++k)
+    {
+        Poly n, d;
+        DiscreteRealization::normalize(num[k], den[k], n, d);
+        Eigen::MatrixXd a;
+        Eigen::VectorXd b;
+        Eigen::RowVectorXd c;
+        double dd;
+        DiscreteRealization::tf2ss(n, d, a, b, c, dd);
+        int order = a.rows();
+        A.block(offset[k], offset[k], order, order) = a;
+        B.block(offset[k], input[k], order, 1) = b;
+        C.block(output[k], offset[k], 1, order) = c;
+        D(output[k], input[k]) += dd;
+    }
+
+    const IntegrationMethod methods[] = {TUSTIN, FORWARD_EULER, BACKWARD_EULER, ZOH, FOH};
+    const double ts = 0.02;
+    Eigen::MatrixXd u = Eigen::MatrixXd::Random(2, 100);
+    for (IntegrationMethod method : methods)
+    {
+        double prewarp = (method == TUSTIN) ? 2 : 0;
+        MIMOSystem mimo(std::make_shared<const MIMORealization>(A, B, C, D, ts, method, prewarp));
+        Eigen::MatrixXd y;
+        mimo.process(u, y);
+
+        Eigen::MatrixXd expected = Eigen::MatrixXd::Zero(2, 100);
+        for (int k = 0; k < 3; ++k)
+        {
+            LinearSystem siso(num[k], den[k], ts, method, prewarp);
+            siso.setInitialTime(0);
+            Eigen::VectorXd u_k(1);
+            for (int i = 0; i < 100; ++i)
+            {
+                u_k << u(input[k], i);
+                expected(output[k], i) += siso.update(u_k, LinearSystem::getTimeFromSeconds((i + 1) * ts) + 1)(0);
+            }
+        }
+        double max_error = (y - expected).cwiseAbs().maxCoeff();
+        if (max_error > 1e-9)
+        {
+            BOOST_ERROR("MIMO output differs from the SISO filters");
+            std::cout << "method = " << method << ", max error = " << max_error << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_simulation)
+{
+    std::cout << "[TEST] batched scenarios" << std::endl;
+    // spans several blocks, with a partial one at the end
+    const unsigned int n_scenarios = 600, n = 150;
+    Poly num(3), den(4);
+    num << 1, 0.5, 2;
+    den << 1, 2, 3, 4;
+    LinearSystem sys(num, den, 0.01);
+    sys.useNFilters(n_scenarios);
+    sys.setInitialTime(0);
+    Eigen::MatrixXd initial_state = Eigen::MatrixXd::Random(n_scenarios, sys.getOrder());
+    sys.setState(initial_state);
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(n_scenarios, n);
+
+    Eigen::MatrixXd expected(n_scenarios, n);
+    for (unsigned int k = 0; k < n; ++k)
+        expected.col(k) = sys.update(input.col(k).transpose(), LinearSystem::getTimeFromSeconds((k + 1) * 0.01) + 1);
+
+    Eigen::MatrixXd output = simulateBatch(*sys.getRealization(), input, initial_state, 3);
+    BOOST_CHECK_SMALL((output - expected).cwiseAbs().maxCoeff(), 1e-10);
+
+    // from rest, every scenario sees the same filter
+    output = simulateBatch(*sys.getRealization(), input, 0);
+    LinearSystem single(sys.getRealization());
+    single.setInitialTime(0);
+    Eigen::VectorXd u(1);
+    for (unsigned int k = 0; k < n; ++k)
+    {
+        u << input(417, k);
+        BOOST_CHECK_SMALL(single.update(u, LinearSystem::getTimeFromSeconds((k + 1) * 0.01) + 1)(0) - output(417, k), 1e-12);
+    }
+
+    BOOST_CHECK_THROW(simulateBatch(*sys.getRealization(), input, initial_state.topRows(10)), std::logic_error);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_parameter_sweep)
+{
+    std::cout << "[TEST] parameter sweeps" << std::endl;
+    std::vector<Eigen::VectorXd> axes(2);
+    axes[0] = Eigen::Vector2d(0.3, 0.6);
+    axes[1] = Eigen::Vector3d(5, 10, 20);
+    Eigen::MatrixXd grid = cartesianGrid(axes);
+    BOOST_CHECK_EQUAL(grid.rows(), 6);
+    BOOST_CHECK_EQUAL(grid(1, 0), 0.3);
+    BOOST_CHECK_EQUAL(grid(1, 1), 10);
+    BOOST_CHECK_EQUAL(grid(5, 0), 0.6);
+
+    // standard underdamped second order, whose metrics are known in closed form
+    DesignFunction design = [](const Eigen::VectorXd &p) {
+        Poly num(1), den(3);
+        num << p(1) * p(1);
+        den << 1, 2 * p(0) * p(1), p(1) * p(1);
+        return std::make_shared<const DiscreteRealization>(num, den, 0.0001, TUSTIN, 0);
+    };
+    Eigen::MatrixXd table = sweepStepResponse(design, grid, 5, 0.02, 4);
+    BOOST_CHECK_EQUAL(table.rows(), 6);
+    for (Eigen::Index i = 0; i < grid.rows(); ++i)
+    {
+        double damp = grid(i, 0), wn = grid(i, 1);
+        StepMetrics metrics = stepResponseMetrics(*design(grid.row(i).transpose()), 5);
+        BOOST_CHECK_EQUAL(table(i, 0), metrics.rise_time);
+        BOOST_CHECK_EQUAL(table(i, 1), metrics.overshoot);
+        BOOST_CHECK_EQUAL(table(i, 2), metrics.settling_time);
+        BOOST_CHECK_CLOSE(metrics.final_value, 1, 1e-6);
+        BOOST_CHECK_SMALL(metrics.overshoot - std::exp(-M_PI * damp / std::sqrt(1 - damp * damp)), 1e-4);
+        // rough envelope estimates
+        BOOST_CHECK(metrics.rise_time > 0.5 / wn && metrics.rise_time < 2.5 / wn);
+        BOOST_CHECK(metrics.settling_time > 2 / (damp * wn) && metrics.settling_time < 5 / (damp * wn));
+    }
+
+    // a horizon too short to settle
+    StepMetrics metrics = stepResponseMetrics(*design(Eigen::Vector2d(0.3, 5)), 0.1);
+    BOOST_CHECK(std::isinf(metrics.settling_time));
+
+    grid.resize(2, 3);
+    grid << 1, 0.5, 0.5,
+            1, 0.5, 0;
+    BOOST_CHECK_THROW(sweepReferenceFilter2I(grid, 1, 0.02, 2), std::logic_error);
+    table = sweepReferenceFilter2I(grid.topRows(1), 20);
+    BOOST_CHECK(std::isfinite(table(0, 2)));
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_fixed_filter)
+{
+    std::cout << "[TEST] compile-time designs" << std::endl;
+    constexpr FixedCoefficients<2> coefficients = design::secondOrder<TUSTIN>(0.7, 10, 0.001);
+    static_assert(coefficients.den[0] == 1, "the design must be evaluated at compile time");
+
+    // same coefficients as the runtime design, for every supported method
+    Eigen::VectorXd num, den;
+    Builder::createSecondOrder(0.7, 10).getCoefficients(num, den);
+    for (int i = 0; i < 3; ++i)
+    {
+        BOOST_CHECK_SMALL(coefficients.num[i] - num(i), 1e-12);
+        BOOST_CHECK_SMALL(coefficients.den[i] - den(i), 1e-12);
+    }
+
+    const FixedCoefficients<2> designs[] = {
+        design::referenceFilter2I<FORWARD_EULER>(2, 3, 0.5, 0.01),
+        design::referenceFilter2I<BACKWARD_EULER>(2, 3, 0.5, 0.01),
+        design::referenceFilter2I<TUSTIN>(2, 3, 0.5, 0.01)};
+    const IntegrationMethod methods[] = {FORWARD_EULER, BACKWARD_EULER, TUSTIN};
+    Poly cont_num(1), cont_den(3);
+    cont_num << 3;
+    cont_den << 0.5, 2, 3;
+    Eigen::VectorXd input = Eigen::VectorXd::Random(200);
+    for (int k = 0; k < 3; ++k)
+    {
+        LinearSystem sys(cont_num, cont_den, 0.01, methods[k]);
+        sys.getCoefficients(num, den);
+        for (int i = 0; i < 3; ++i)
+        {
+            BOOST_CHECK_SMALL(designs[k].num[i] - num(i), 1e-12);
+            BOOST_CHECK_SMALL(designs[k].den[i] - den(i), 1e-12);
+        }
+
+        // and the same outputs
+        FixedFilter<2> filter(designs[k]);
+        sys.setInitialTime(0);
+        Eigen::VectorXd u(1);
+        for (int i = 0; i < input.size(); ++i)
+        {
+            u << input(i);
+            double y = sys.update(u, LinearSystem::getTimeFromSeconds((i + 1) * 0.01) + 1)(0);
+            BOOST_CHECK_SMALL(filter.update(input(i)) - y, 1e-12);
+        }
+    }
+
+    constexpr FixedCoefficients<1> first = design::referenceFilterI<TUSTIN>(2, 3, 0.01);
+    LinearSystem sys(Builder::createReferenceFilterI(2, 3).getRealization());
+    Eigen::VectorXd u = Eigen::VectorXd::Ones(1);
+    sys.setInitialTime(0);
+    LinearSystem fixed(realize(design::referenceFilterI<TUSTIN>(2, 3, 0.001)));
+    fixed.setInitialTime(0);
+    for (int i = 0; i < 10; ++i)
+        BOOST_CHECK_SMALL(sys.update(u, (i + 1) * 1000 + 1)(0) - fixed.update(u, (i + 1) * 1000 + 1)(0), 1e-12);
+    BOOST_CHECK_EQUAL(FixedFilter<1>(first).getSampling(), 0.01);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_filter_bank_precision)
+{
+    std::cout << "[TEST] single and mixed precision" << std::endl;
+    const unsigned int n_filters = 37, n = 2000;
+    Poly num(3), den(4);
+    num << 1, 0.5, 2;
+    den << 1, 2, 3, 4;
+    LinearSystem sys(num, den, 0.1);
+    sys.useNFilters(n_filters);
+    sys.setInitialTime(0);
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(n_filters, n);
+    Eigen::MatrixXd expected(n_filters, n);
+    for (unsigned int k = 0; k < n; ++k)
+        expected.col(k) = sys.update(input.col(k).transpose(), LinearSystem::getTimeFromSeconds((k + 1) * 0.1) + 1);
+    double scale = expected.cwiseAbs().maxCoeff();
+
+    DoubleFilterBank reference(sys.getRealization(), n_filters);
+    Eigen::MatrixXd output;
+    reference.process(input, output);
+    BOOST_CHECK_SMALL((output - expected).cwiseAbs().maxCoeff() / scale, 1e-12);
+    BOOST_CHECK_SMALL((reference.getState() - sys.getState()).cwiseAbs().maxCoeff() / sys.getState().cwiseAbs().maxCoeff(), 1e-12);
+
+    FloatFilterBank single(sys.getRealization(), n_filters);
+    MixedFilterBank mixed(sys.getRealization(), n_filters);
+    Eigen::MatrixXf output_single, output_mixed;
+    single.process(input.cast<float>(), output_single);
+    mixed.process(input.cast<float>(), output_mixed);
+    double error_single = (output_single.cast<double>() - expected).cwiseAbs().maxCoeff() / scale;
+    double error_mixed = (output_mixed.cast<double>() - expected).cwiseAbs().maxCoeff() / scale;
+    std::cout << "relative error: float " << error_single << ", mixed " << error_mixed << std::endl;
+    BOOST_CHECK_SMALL(error_single, 2e-4);
+    BOOST_CHECK_SMALL(error_mixed, 5e-5);
+
+    BOOST_CHECK_THROW(single.setState(Eigen::MatrixXf::Zero(n_filters, 2)), std::logic_error);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_fixed_point)
+{
+    std::cout << "[TEST] fixed-point filters" << std::endl;
+    const unsigned int n = 5000;
+    const double range = 10;
+    Eigen::VectorXd input = range * Eigen::VectorXd::Random(n);
+
+    LinearSystem systems[] = {Builder::createSecondOrder(0.7, 10), Builder::createReferenceFilter2I(20, 50, 1),
+                              LinearSystem(Poly::Constant(1, 4), Eigen::Vector4d(1, 2, 3, 4), 0.1)};
+    for (LinearSystem &sys : systems)
+    {
+        std::shared_ptr<const FixedPointRealization> realization =
+            std::make_shared<const FixedPointRealization>(*sys.getRealization(), range);
+        FixedPointFilter filter(realization);
+        sys.setInitialTime(0);
+        Eigen::VectorXd u(1), expected(n), output(n);
+        for (unsigned int k = 0; k < n; ++k)
+        {
+            u << input(k);
+            expected(k) = sys.update(u, (k + 1) * sys.getSamplingMicro() + 1)(0);
+            output(k) = filter.update(input(k));
+        }
+        double error = (output - expected).cwiseAbs().maxCoeff() / expected.cwiseAbs().maxCoeff();
+        std::cout << "order " << sys.getOrder() << ": relative error " << error << std::endl;
+        BOOST_CHECK_SMALL(error, 1e-4);
+
+        // the same integer inputs always give the same integer outputs
+        FixedPointFilter other(realization);
+        filter.reset();
+        for (unsigned int k = 0; k < 100; ++k)
+        {
+            int32_t q = realization->quantizeInput(input(k));
+            BOOST_CHECK_EQUAL(filter.update(q), other.update(q));
+        }
+    }
+
+    // out-of-range inputs saturate instead of wrapping around
+    FixedPointFilter filter(std::make_shared<const FixedPointRealization>(*Builder::createReferenceFilterI(2, 3).getRealization(), 1));
+    double y = 0;
+    for (unsigned int k = 0; k < 5000; ++k)
+        y = filter.update(1e6);
+    BOOST_CHECK(y > 1.5);
+
+    BOOST_CHECK_THROW(FixedPointRealization(*LinearSystem(Poly::Ones(1), Eigen::Vector2d(1, 0)).getRealization(), 1), std::logic_error);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_realization_forms)
+{
+    std::cout << "[TEST] modal and balanced realizations" << std::endl;
+    // 8th order Butterworth filter, as a product of second order sections
+    const unsigned int order = 8;
+    const double cutoff = 2 * M_PI * 5, ts = 0.001;
+    Poly den = Poly::Ones(1);
+    for (unsigned int k = 0; k < order / 2; ++k)
+    {
+        double damp = std::sin(M_PI * (2 * k + 1) / (2 * order));
+        Poly section(3), product = Poly::Zero(den.size() + 2);
+        section << 1, 2 * damp * cutoff, cutoff * cutoff;
+        for (Eigen::Index i = 0; i < den.size(); ++i)
+            product.segment(i, 3) += den(i) * section;
+        den = product;
+    }
+    Poly num = Poly::Constant(1, std::pow(cutoff, order));
+
+    const RealizationForm forms[] = {CONTROLLABLE_CANONICAL, MODAL, BALANCED};
+    const unsigned int n = 3000;
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(2, n);
+    Eigen::MatrixXd outputs(3, n);
+    Eigen::Vector3d errors;
+    for (int f = 0; f < 3; ++f)
+    {
+        LinearSystem sys(num, den, ts, TUSTIN, 0, forms[f]);
+        BOOST_CHECK_EQUAL(sys.getRealizationForm(), forms[f]);
+        sys.useNFilters(2);
+        sys.setInitialTime(0);
+        for (unsigned int k = 0; k < n; ++k)
+            outputs(f, k) = sys.update(input.col(k).transpose(), LinearSystem::getTimeFromSeconds((k + 1) * ts) + 1)(1);
+
+        // compare with the exact Tustin map of the continuous-time response
+        const DiscreteRealization &r = *sys.getRealization();
+        std::complex<double> z = std::polar(1.0, 0.3), s = 2 / ts * (z - 1.0) / (z + 1.0);
+        std::complex<double> expected = num(0), poly = 0;
+        for (Eigen::Index i = 0; i <= order; ++i)
+            poly = poly * s + den(i);
+        expected /= poly;
+        Eigen::MatrixXcd resolvent = (z * Eigen::MatrixXcd::Identity(order, order) - r.getA().cast<std::complex<double> >()).inverse();
+        std::complex<double> actual = (r.getC().cast<std::complex<double> >() * resolvent * r.getB().cast<std::complex<double> >())(0) + r.getD();
+        errors(f) = std::abs(actual - expected) / std::abs(expected);
+    }
+    std::cout << "response error: canonical " << errors(0) << ", modal " << errors(1) << ", balanced " << errors(2) << std::endl;
+    BOOST_CHECK_SMALL(errors(1), 1e-6);
+    BOOST_CHECK_SMALL(errors(2), 1e-6);
+
+    double scale = outputs.row(0).cwiseAbs().maxCoeff();
+    std::cout << "canonical vs modal " << (outputs.row(0) - outputs.row(1)).cwiseAbs().maxCoeff() / scale
+              << ", modal vs balanced " << (outputs.row(1) - outputs.row(2)).cwiseAbs().maxCoeff() / scale << std::endl;
+    BOOST_CHECK_SMALL((outputs.row(1) - outputs.row(2)).cwiseAbs().maxCoeff() / scale, 1e-9);
+
+    // the modal form is block diagonal
+    LinearSystem modal(num, den, ts, TUSTIN, 0, MODAL);
+    const Eigen::MatrixXd &A = modal.getRealization()->getA();
+    BOOST_CHECK_EQUAL((A.array() != 0).count(), 2 * order);
+
+    BOOST_CHECK_THROW(LinearSystem(Poly::Ones(1), Eigen::Vector3d(1, 2, 1), ts, TUSTIN, 0, MODAL), std::logic_error);
+    BOOST_CHECK_THROW(LinearSystem(Poly::Ones(1), Eigen::Vector2d(1, 0), ts, TUSTIN, 0, BALANCED), std::logic_error);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_coefficient_bank)
+{
+    std::cout << "[TEST] banks of filters with their own coefficients" << std::endl;
+    const unsigned int n = 500;
+    Eigen::VectorXd damp(4), cutoff(4);
+    damp << 0.3, 0.7, 1, 2;
+    cutoff << 1, 10, 50, 200;
+    CoefficientBank bank = Builder::createSecondOrderBank(damp, cutoff);
+    BOOST_CHECK_EQUAL(bank.getNFilters(), 4);
+    BOOST_CHECK_EQUAL(bank.getOrder(), 2);
+
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(4, n), output;
+    bank.process(input, output);
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        LinearSystem sys = Builder::createSecondOrder(damp(i), cutoff(i));
+        BOOST_CHECK(bank.getRealization(i) == sys.getRealization());
+        DoubleFilterBank single(sys.getRealization(), 1);
+        Eigen::MatrixXd expected;
+        single.process(input.row(i), expected);
+        BOOST_CHECK_SMALL((output.row(i) - expected).cwiseAbs().maxCoeff(), 1e-12);
+        BOOST_CHECK_SMALL((bank.getState().row(i) - single.getState()).cwiseAbs().maxCoeff(), 1e-12);
+    }
+
+    // in place, sample by sample
+    bank.reset();
+    Eigen::VectorXd sample(4);
+    for (unsigned int k = 0; k < n; ++k)
+    {
+        sample = input.col(k);
+        bank.update(sample, sample);
+        BOOST_CHECK_SMALL((sample - output.col(k)).cwiseAbs().maxCoeff(), 1e-12);
+    }
+
+    Eigen::VectorXd kp = Eigen::VectorXd::Constant(3, 20), ki(3), kd = Eigen::VectorXd::Ones(3);
+    ki << 10, 50, 100;
+    CoefficientBank reference = Builder::createReferenceFilter2IBank(kp, ki, kd);
+    BOOST_CHECK_EQUAL(reference.getOrder(), 2);
+    BOOST_CHECK_THROW(Builder::createReferenceFilterIBank(kp, Eigen::VectorXd::Ones(2)), std::logic_error);
+
+    // filters of different orders cannot share a bank
+    std::vector<std::shared_ptr<const DiscreteRealization> > mixed = {
+        Builder::createSecondOrder(0.7, 10).getRealization(), Builder::createReferenceFilterI(2, 3).getRealization()};
+    BOOST_CHECK_THROW(CoefficientBank bad(mixed), std::logic_error);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_thread_pool)
+{
+    std::cout << "[TEST] thread pool" << std::endl;
+    const unsigned int n_banks = 6, n = 300;
+    Eigen::VectorXd damp = Eigen::VectorXd::LinSpaced(50, 0.2, 1.5), cutoff = Eigen::VectorXd::Constant(50, 20);
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(50, n), expected;
+    CoefficientBank reference = Builder::createSecondOrderBank(damp, cutoff);
+    reference.process(input, expected);
+
+    std::vector<CoefficientBank> banks(n_banks, reference);
+    for (CoefficientBank &bank : banks)
+        bank.reset();
+    std::vector<std::future<Eigen::MatrixXd> > results;
+    {
+        ThreadPool pool(3);
+        BOOST_CHECK_EQUAL(pool.size(), 3);
+        for (CoefficientBank &bank : banks)
+        {
+            results.push_back(pool.submit([&bank, &input]() {
+                Eigen::MatrixXd output;
+                bank.process(input, output);
+                return output;
+            }));
+        }
+        std::future<int> failure = pool.submit([]() -> int {throw std::logic_error("failed");});
+        BOOST_CHECK_THROW(failure.get(), std::logic_error);
+    }
+    for (std::future<Eigen::MatrixXd> &result : results)
+        BOOST_CHECK_EQUAL((result.get() - expected).cwiseAbs().maxCoeff(), 0);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_convolution_engine)
+{
+    std::cout << "[TEST] convolution engine" << std::endl;
+    const unsigned int n_filters = 3, block = 64, n = 20 * block;
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(n_filters, n), expected, output;
+
+    // A long FIR filter, whose impulse response is exact, and a slowly decaying IIR filter
+    Poly fir_num = Poly::Random(300), fir_den = Poly::Zero(300);
+    fir_den(0) = 1;
+    std::shared_ptr<const DiscreteRealization> filters[] = {
+        DesignCache::instance().get(fir_num, fir_den, 0.001, DIRECT, 0),
+        Builder::createSecondOrder(0.7, 10).getRealization()};
+    for (const std::shared_ptr<const DiscreteRealization> &filter : filters)
+    {
+        DoubleFilterBank reference(filter, n_filters);
+        reference.process(input, expected);
+
+        ConvolutionEngine engine(filter, n_filters, block, OVERLAP_SAVE);
+        BOOST_CHECK_EQUAL(engine.getMode(), OVERLAP_SAVE);
+        // two calls, to check that blocks carry over between calls
+        engine.process(input.leftCols(n / 2), output);
+        Eigen::MatrixXd second;
+        engine.process(input.rightCols(n / 2), second);
+        double error = std::max((output - expected.leftCols(n / 2)).cwiseAbs().maxCoeff(),
+                                (second - expected.rightCols(n / 2)).cwiseAbs().maxCoeff());
+        std::cout << "impulse length " << engine.getImpulseLength() << ": error " << error << std::endl;
+        BOOST_CHECK_SMALL(error / expected.cwiseAbs().maxCoeff(), 1e-10);
+
+        engine.reset();
+        engine.process(input, output);
+        BOOST_CHECK_SMALL((output - expected).cwiseAbs().maxCoeff() / expected.cwiseAbs().maxCoeff(), 1e-10);
+    }
+    BOOST_CHECK_EQUAL(ConvolutionEngine::impulseResponse(*filters[0], 1e-12).size(), 300);
+
+    // Three lightly damped pole pairs, whose companion realization is far from normal: the tail
+    // of the impulse response is much larger than the samples at the cut suggest
+    Eigen::Vector3d pair(1, 2 * 0.05 * 20, 400);
+    Eigen::Matrix<double, 5, 1> two_pairs;
+    polynomial::multiply(pair, pair, two_pairs);
+    Poly resonant_den(7);
+    polynomial::multiply(two_pairs, pair, resonant_den);
+    std::shared_ptr<const DiscreteRealization> resonant =
+        DesignCache::instance().get(Poly::Constant(1, 400 * 400 * 400), resonant_den, 0.001, TUSTIN, 0);
+    for (double tolerance : {1e-6, 1e-9})
+    {
+        // none of the dropped samples exceeds the tolerance, even much later
+        Eigen::VectorXd impulse = ConvolutionEngine::impulseResponse(*resonant, tolerance);
+        Eigen::VectorXd x = resonant->getB();
+        double dropped = 0;
+        for (Eigen::Index k = 1; k < 4 * impulse.size(); ++k, x = resonant->getA() * x)
+        {
+            if (k >= impulse.size())
+                dropped = std::max(dropped, std::abs(resonant->getC().dot(x)));
+        }
+        std::cout << "resonant impulse length " << impulse.size() << ": largest dropped sample "
+                  << dropped / impulse.lpNorm<1>() << " of the L1 norm" << std::endl;
+        BOOST_CHECK_LE(dropped, tolerance * impulse.lpNorm<1>());
+    }
+
+    // Any double precision recursion of that triple pole pair loses ~1e-5 to rounding, so the FFT
+    // path is checked against the convolution with its truncated impulse response instead
+    ConvolutionEngine resonant_engine(resonant, n_filters, block, OVERLAP_SAVE, 1e-9);
+    Eigen::VectorXd impulse = ConvolutionEngine::impulseResponse(*resonant, 1e-9);
+    BOOST_CHECK_EQUAL(resonant_engine.getImpulseLength(), impulse.size());
+    resonant_engine.process(input, output);
+    expected = Eigen::MatrixXd::Zero(n_filters, n);
+    for (unsigned int k = 0; k < n; ++k)
+    {
+        for (unsigned int j = 0; j <= k && j < impulse.size(); ++j)
+            expected.col(k) += impulse(j) * input.col(k - j);
+    }
+    BOOST_CHECK_SMALL((output - expected).cwiseAbs().maxCoeff() / expected.cwiseAbs().maxCoeff(), 1e-10);
+    // the recursion is cheaper for low orders, the FFTs for long FIR filters
+    BOOST_CHECK_EQUAL(ConvolutionEngine(filters[0], 1, 256).getMode(), OVERLAP_SAVE);
+    BOOST_CHECK_EQUAL(ConvolutionEngine(filters[1], 1, 256).getMode(), RECURRENCE);
+
+    ConvolutionEngine engine(filters[0], n_filters, block);
+    BOOST_CHECK_THROW(engine.process(input.leftCols(block + 1), output), std::logic_error);
+    // an integrator has no finite impulse response to truncate
+    BOOST_CHECK_THROW(ConvolutionEngine(DesignCache::instance().get(Poly::Ones(1), Eigen::Vector2d(1, 0), 0.001, TUSTIN, 0),
+                                        1, block, OVERLAP_SAVE), std::logic_error);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_parallel_in_time)
+{
+    std::cout << "[TEST] parallel-in-time filtering" << std::endl;
+    // long enough for several segments, with a shorter last one
+    const unsigned int n = 30001;
+    Poly num(3), den(4);
+    num << 1, 0.5, 2;
+    den << 1, 2, 3, 4;
+    std::shared_ptr<const DiscreteRealization> realization = DesignCache::instance().get(num, den, 0.01, TUSTIN, 0);
+    Eigen::VectorXd input = Eigen::VectorXd::Random(n);
+    Eigen::VectorXd initial_state = Eigen::VectorXd::Random(3);
+
+    // the canonical realization loses ~1e-11 either way, only in a different order
+    Eigen::MatrixXd expected = simulateBatch(*realization, input.transpose(), initial_state.transpose());
+    Eigen::VectorXd output = simulateParallelInTime(*realization, input, initial_state, 5);
+    BOOST_CHECK_SMALL((output - expected.row(0).transpose()).cwiseAbs().maxCoeff() / expected.cwiseAbs().maxCoeff(), 1e-10);
+
+    expected = simulateBatch(*realization, input.transpose());
+    for (unsigned int n_threads = 1; n_threads <= 8; n_threads *= 2)
+    {
+        output = simulateParallelInTime(*realization, input, n_threads);
+        BOOST_CHECK_SMALL((output - expected.row(0).transpose()).cwiseAbs().maxCoeff() / expected.cwiseAbs().maxCoeff(), 1e-10);
+    }
+
+    // inputs too short to split run sequentially
+    output = simulateParallelInTime(*realization, input.head(100), 4);
+    BOOST_CHECK_SMALL((output - expected.row(0).head(100).transpose()).cwiseAbs().maxCoeff(), 1e-12);
+    BOOST_CHECK_THROW(simulateParallelInTime(*realization, input, Eigen::VectorXd::Zero(2)), std::logic_error);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_filtfilt)
+{
+    std::cout << "[TEST] zero-phase filtering" << std::endl;
+    const unsigned int n_channels = 300, n = 400;
+    // unit DC gain low-pass
+    const double w = 2 * M_PI * 10;
+    std::shared_ptr<const DiscreteRealization> realization =
+        DesignCache::instance().get(Poly::Constant(1, w * w), Eigen::Vector3d(1, 1.4 * w, w * w), 0.001, TUSTIN, 0);
+    const unsigned int order = realization->getOrder(), p = 3 * (order + 1);
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(n_channels, n);
+
+    // Reference: extend the input, run it forward from the scaled steady state, reverse it and
+    // run it again
+    Eigen::VectorXd unit_state = (Eigen::MatrixXd::Identity(order, order) - realization->getA()).inverse() * realization->getB();
+    Eigen::MatrixXd extended(n_channels, n + 2 * p);
+    for (unsigned int k = 0; k < p; ++k)
+    {
+        extended.col(k) = 2 * input.col(0) - input.col(p - k);
+        extended.col(p + n + k) = 2 * input.col(n - 1) - input.col(n - 2 - k);
+    }
+    extended.middleCols(p, n) = input;
+    DoubleFilterBank bank(realization, n_channels);
+    Eigen::MatrixXd forward, backward;
+    bank.setState(extended.col(0) * unit_state.transpose());
+    bank.process(extended, forward);
+    Eigen::MatrixXd reversed = forward.rowwise().reverse();
+    bank.setState(reversed.col(0) * unit_state.transpose());
+    bank.process(reversed, backward);
+    Eigen::MatrixXd expected = backward.rowwise().reverse().middleCols(p, n);
+
+    Eigen::MatrixXd output = filtfilt(*realization, input, -1, 2);
+    BOOST_CHECK_SMALL((output - expected).cwiseAbs().maxCoeff(), 1e-12);
+
+    // a constant input is in steady state from the first sample, without edge transients
+    output = filtfilt(*realization, Eigen::MatrixXd::Constant(1, n, 3), 0);
+    BOOST_CHECK_SMALL((output.array() - 3).abs().maxCoeff(), 1e-9);
+
+    // away from the edges, a sinusoid well within the passband comes out without any delay
+    Eigen::RowVectorXd t = Eigen::RowVectorXd::LinSpaced(10 * n, 0, (10 * n - 1) * realization->getSampling());
+    Eigen::MatrixXd sine = (2 * M_PI * 0.5 * t).array().sin().matrix();
+    output = filtfilt(*realization, sine);
+    BOOST_CHECK_SMALL((output - sine).middleCols(n, 8 * n).cwiseAbs().maxCoeff(), 1e-3);
+
+    BOOST_CHECK_THROW(filtfilt(*realization, input.leftCols(p)), std::logic_error);
+
+    // the passes start from the state setInitialState gives for constant inputs and outputs
+    Eigen::VectorXd u = Eigen::VectorXd::LinSpaced(3, -2, 5);
+    for (RealizationForm form : {CONTROLLABLE_CANONICAL, MODAL})
+    {
+        DiscreteRealization filter(Eigen::Vector3d(1, 2, w * w), Eigen::Vector3d(1, 0.6 * w, w * w), 0.001, TUSTIN, 0, form);
+        Eigen::VectorXd steady = filter.unitSteadyState();
+        double gain = filter.getD() + filter.getC() * steady;
+        FilterState fstate;
+        fstate.reset(3, order);
+        Eigen::MatrixXd derivatives = Eigen::MatrixXd::Zero(3, order);
+        derivatives.col(0) = gain * u;
+        filter.setInitialState(fstate, u.replicate(1, order), derivatives);
+        BOOST_CHECK_SMALL((fstate.state - u * steady.transpose()).cwiseAbs().maxCoeff(), 1e-9);
+    }
+    BOOST_CHECK_THROW(filtfilt(DiscreteRealization(Poly::Ones(1), Eigen::Vector2d(1, 0), 0.001, TUSTIN, 0), input),
+                      std::logic_error);
+    std::cout << std::endl;
+}
+
+
+BOOST_AUTO_TEST_CASE(test_variable_step)
+{
+    std::cout << "[TEST] variable-step updates" << std::endl;
+    const unsigned int n_filters = 3, n = 500;
+    const double w = 2 * M_PI * 10;
+    Poly num = Poly::Constant(1, w * w), den = Eigen::Vector3d(1, 1.4 * w, w * w);
+    std::shared_ptr<const DiscreteRealization> realization =
+        DesignCache::instance().get(num, den, 0.001, ZOH, 0);
+    Eigen::MatrixXd input = Eigen::MatrixXd::Random(n, n_filters);
+
+    // with a regular clock, from rest, every update is the ZOH step of LinearSystem
+    VariableStepSystem variable(realization);
+    variable.useNFilters(n_filters);
+    variable.setInitialTime(0);
+    LinearSystem fixed(realization);
+    fixed.useNFilters(n_filters);
+    fixed.setInitialTime(0);
+    for (unsigned int k = 1; k <= n; ++k)
+    {
+        Output expected = fixed.update(input.row(k - 1), k * 1000);
+        Output output = variable.update(input.row(k - 1), k * 1000);
+        BOOST_CHECK_SMALL((output - expected).cwiseAbs().maxCoeff(), 1e-12);
+    }
+    BOOST_CHECK_EQUAL(variable.getCacheSize(), 1u);
+
+    // with a jittery clock, every update is the exact ZOH step over the elapsed time
+    Eigen::MatrixXd Ac, Ad, Bd, Cd, Dd;
+    Eigen::VectorXd Bc;
+    Eigen::RowVectorXd Cc;
+    double Dc;
+    DiscreteRealization::tf2ss(realization->getContinuousNumerator(), realization->getContinuousDenominator(),
+                               Ac, Bc, Cc, Dc);
+    VariableStepSystem jittery(realization);
+    jittery.useNFilters(n_filters);
+    jittery.setInitialTime(0);
+    Eigen::MatrixXd x = Eigen::MatrixXd::Zero(n_filters, Ac.rows());
+    Input held = Input::Zero(n_filters);
+    Time time = 0;
+    for (unsigned int k = 0; k < n; ++k)
+    {
+        Time delta = 700 + (k * 7919) % 600;
+        time += delta;
+        MIMORealization::discretize(Ac, Bc, Cc, Eigen::MatrixXd::Constant(1, 1, Dc), delta * 1e-6, ZOH, 0, Ad, Bd, Cd, Dd);
+        x = (x * Ad.transpose() + held.transpose() * Bd.transpose()).eval();
+        held = input.row(k);
+        Output expected = x * Cc.transpose() + Dc * held.transpose();
+        Output output = jittery.update(input.row(k), time);
+        BOOST_CHECK_SMALL((output - expected).cwiseAbs().maxCoeff(), 1e-10);
+    }
+    BOOST_CHECK_LE(jittery.getCacheSize(), 600u);
+
+    // a coarser quantum shares the steps, and its rounding does not accumulate in time
+    VariableStepSystem coarse(realization, 100);
+    coarse.setInitialTime(0);
+    time = 0;
+    for (unsigned int k = 0; k < n; ++k)
+    {
+        time += 700 + (k * 7919) % 600;
+        coarse.update(input.row(k).head(1), time);
+    }
+    BOOST_CHECK_LE(coarse.getCacheSize(), 7u);
+    BOOST_CHECK_SMALL((coarse.getOutput() - jittery.getOutput().head(1)).cwiseAbs().maxCoeff(), 0.02);
+
+    // an update at the same time only changes the direct feedthrough
+    Eigen::MatrixXd state = jittery.getState();
+    jittery.update(Input::Zero(n_filters), time);
+    BOOST_CHECK(jittery.getState() == state);
+
+    std::shared_ptr<const DiscreteRealization> direct =
+        DesignCache::instance().get(Eigen::Vector2d(0, 0.5), Eigen::Vector2d(1, -0.5), 0.001, DIRECT, 0);
+    BOOST_CHECK_THROW(VariableStepSystem bad(direct), std::logic_error);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_perf_profile)
+{
+    std::cout << "[TEST] performance counter profiles" << std::endl;
+    // the sections only collect in instrumented builds
+    const uint64_t instrumented = PerfProfile::compiledIn() ? 1 : 0;
+    std::shared_ptr<PerfProfile> profile = std::make_shared<PerfProfile>();
+
+    LinearSystem sys = Builder::createSecondOrder(0.7, 5);
+    sys.setProfile(profile);
+    sys.setInitialTime(0);
+    for (int k = 1; k <= 100; ++k)
+        sys.update(Input::Constant(1, 1), k * sys.getSamplingMicro());
+    sys.setInitialConditions(Eigen::MatrixXd::Ones(1, sys.getOrder()), Eigen::MatrixXd::Zero(1, sys.getOrder()));
+    BOOST_CHECK_EQUAL(profile->get(PERF_UPDATE).calls, 100 * instrumented);
+    BOOST_CHECK_EQUAL(profile->get(PERF_SET_INITIAL_STATE).calls, instrumented);
+
+    // banks sharing the profile add one update per sample
+    DoubleFilterBank bank(sys.getRealization(), 10);
+    bank.setProfile(profile);
+    Eigen::MatrixXd output;
+    bank.process(Eigen::MatrixXd::Random(10, 20), output);
+    BOOST_CHECK_EQUAL(profile->get(PERF_UPDATE).calls, 120 * instrumented);
+    if (!PerfProfile::countersAvailable())
+        BOOST_CHECK_EQUAL(profile->get(PERF_UPDATE).cycles, 0u);
+
+    // designs go to the global profile
+    PerfProfile::global().reset();
+    DiscreteRealization design(Eigen::Vector3d(0, 0, 1), Eigen::Vector3d(1, 2, 1), 0.001, TUSTIN, 0);
+    BOOST_CHECK_EQUAL(PerfProfile::global().get(PERF_DISCRETIZE).calls, instrumented);
+    BOOST_CHECK_EQUAL(PerfProfile::global().get(PERF_TF2SS).calls >= instrumented, true);
+
+    std::ostringstream report;
+    profile->report(report, "second order");
+    BOOST_CHECK_EQUAL(report.str().find("second order") != std::string::npos, true);
+    BOOST_CHECK_EQUAL(report.str().find("setInitialState") != std::string::npos, instrumented == 1);
+    profile->reset();
+    BOOST_CHECK_EQUAL(profile->get(PERF_UPDATE).calls, 0u);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_angle_wrapping)
+{
+    std::cout << "[TEST] bulk wrapping and streaming unwrapping" << std::endl;
+    // the bulk kernel agrees with the scalar std::fmod version, and stays in (-pi, pi]
+    Eigen::VectorXd angles = 1000 * Eigen::VectorXd::Random(10000);
+    angles.head(6) << M_PI, -M_PI, 3 * M_PI, -3 * M_PI, 0, 2 * M_PI;
+    Eigen::VectorXd bulk = angles;
+    wrap2pi(bulk);
+    for (Eigen::Index i = 0; i < angles.size(); ++i)
+    {
+        double scalar = angles(i);
+        wrap2pi(scalar);
+        BOOST_CHECK(bulk(i) > -M_PI && bulk(i) <= M_PI);
+        double diff = std::abs(bulk(i) - scalar);
+        BOOST_CHECK_SMALL(std::min(diff, 2 * M_PI - diff), 1e-12);
+    }
+    Eigen::MatrixXd block = angles.head(100).replicate(1, 3);
+    wrap2pi(block.middleRows(10, 50));
+    BOOST_CHECK(block.col(2).segment(10, 50) == bulk.segment(10, 50));
+    BOOST_CHECK(block.col(0).head(10) == angles.head(10));
+
+    // unwrapping recovers ramps of different speeds from their wrapped samples
+    const unsigned int n_channels = 5, n = 2000;
+    Eigen::VectorXd speed(n_channels);
+    speed << 0.1, -0.5, 2, -3, 0.01;
+    Eigen::MatrixXd ramps = speed * Eigen::RowVectorXd::LinSpaced(n, 0, n - 1), wrapped = ramps, unwrapped;
+    wrap2pi(wrapped);
+    Unwrapper unwrapper(n_channels);
+    unwrapper.process(wrapped.leftCols(n / 2), unwrapped);
+    Eigen::VectorXd sample(n_channels);
+    for (unsigned int k = n / 2; k < n; ++k)
+    {
+        // in place, sample by sample, continuing the block
+        sample = wrapped.col(k);
+        unwrapper.update(sample, sample);
+        BOOST_CHECK_SMALL((sample - ramps.col(k)).cwiseAbs().maxCoeff(), 1e-9);
+    }
+    BOOST_CHECK_SMALL((unwrapped - ramps.leftCols(n / 2)).cwiseAbs().maxCoeff(), 1e-9);
+    BOOST_CHECK_CLOSE(unwrapper.getTurns()(2), std::round(2 * (n - 1) / (2 * M_PI)), 1e-9);
+
+    unwrapper.reset();
+    unwrapper.update(wrapped.col(n - 1), sample);
+    BOOST_CHECK(sample == wrapped.col(n - 1));
+    BOOST_CHECK_THROW(unwrapper.update(Eigen::VectorXd::Zero(2), sample), std::logic_error);
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_polynomial_toolkit)
+{
+    std::cout << "[TEST] allocation-free polynomial toolkit" << std::endl;
+    // degrees are relative to the largest coefficient, so scaling never changes them
+    Eigen::Vector4d p(1e-28, 2e-12, 3e-12, 4e-12);
+    BOOST_CHECK_EQUAL(polynomial::degree(p), 2);
+    BOOST_CHECK_EQUAL(polynomial::degree(Eigen::Vector4d(1e20 * p)), 2);
+    BOOST_CHECK_EQUAL(polynomial::degree(Eigen::Vector3d::Zero()), 0);
+
+    // (z^2 + 3z + 2)(z - 1) = z^3 + 2z^2 - z - 2
+    Eigen::Vector3d a(1, 3, 2);
+    Eigen::Vector2d b(1, -1);
+    Eigen::Vector4d product, quotient;
+    polynomial::multiply(a, b, product);
+    BOOST_CHECK(product == Eigen::Vector4d(1, 2, -1, -2));
+    BOOST_CHECK_CLOSE(polynomial::evaluate(product, 2.0), 12, 1e-12);
+
+    // dividing back, plus a remainder of 5
+    Eigen::Vector4d num = product + Eigen::Vector4d(0, 0, 0, 5);
+    polynomial::divide(num, b, quotient);
+    BOOST_CHECK_SMALL((quotient - Eigen::Vector4d(0, 1, 3, 2)).cwiseAbs().maxCoeff(), 1e-12);
+    BOOST_CHECK_SMALL((num - Eigen::Vector4d(0, 0, 0, 5)).cwiseAbs().maxCoeff(), 1e-12);
+    BOOST_CHECK_THROW(polynomial::divide(num, Eigen::Vector2d::Zero(), quotient), std::logic_error);
+
+    // roots of fixed-size polynomials, on the stack
+    Eigen::Matrix<std::complex<double>, 3, 1> roots = polynomial::roots(product);
+    std::vector<double> sorted;
+    for (int i = 0; i < 3; ++i)
+    {
+        BOOST_CHECK_SMALL(roots(i).imag(), 1e-12);
+        sorted.push_back(roots(i).real());
+    }
+    std::sort(sorted.begin(), sorted.end());
+    BOOST_CHECK_CLOSE(sorted[0], -2, 1e-9);
+    BOOST_CHECK_CLOSE(sorted[1], -1, 1e-9);
+    BOOST_CHECK_CLOSE(sorted[2], 1, 1e-9);
+
+    // s = 2 (z - 1) / (z + 1) in s + 1 gives (z + 1)(s + 1) = 3z - 1
+    Eigen::Vector2d out, scratch;
+    polynomial::substitute(Eigen::Vector2d(1, 1), 2, -2, 1, 1, out, scratch);
+    BOOST_CHECK(out == Eigen::Vector2d(3, -1));
+
+    // high orders keep exact binomial coefficients: Tustin maps 1/(s+1)^n to a pole of
+    // multiplicity n at r = (a - 1) / (a + 1), with a = 2 / Ts
+    Poly one = Poly::Ones(1);
+    for (unsigned int order : {5, 12, 20})
+    {
+        Poly den(order + 1), expected(order + 1);
+        const double r = 199.0 / 201.0;
+        for (unsigned int k = 0; k <= order; ++k)
+        {
+            double binomial = std::round(std::tgamma(order + 1) / (std::tgamma(k + 1) * std::tgamma(order - k + 1)));
+            den(k) = binomial;
+            expected(k) = binomial * std::pow(-r, k);
+        }
+        DiscreteRealization realization(one, den, 0.01, TUSTIN, 0, CONTROLLABLE_CANONICAL);
+        double error = (realization.getDenominator() - expected).cwiseAbs().maxCoeff() / expected.cwiseAbs().maxCoeff();
+        BOOST_CHECK_SMALL(error, 1e-12);
+    }
+    std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(test_interconnection)
+{
+    std::cout << "[TEST] series, parallel and feedback interconnections" << std::endl;
+    const double ts = 0.01;
+    LinearSystem lowpass(Eigen::Vector3d(0, 0, 100), Eigen::Vector3d(1, 14, 100), ts, TUSTIN);
+    LinearSystem notch(Eigen::Vector3d(1, 0, 400), Eigen::Vector3d(1, 4, 400), ts, TUSTIN, 0, MODAL);
+    LinearSystem lag(Eigen::Vector2d(1, 2), Eigen::Vector2d(1, 5), ts, ZOH);
+
+    // the fused filters follow the operands run side by side
+    LinearSystem sum = lowpass + notch, difference = lowpass - notch;
+    for (LinearSystem *sys : {&lowpass, &notch, &sum, &difference})
+        sys->setInitialTime(0);
+    Eigen::RowVectorXd u(1), y1(1), y2(1);
+    double error = 0;
+    for (int k = 1; k <= 300; ++k)
+    {
+        u << std::sin(0.05 * k) + (k % 17 == 0);
+        Time time = k * LinearSystem::getTimeFromSeconds(ts);
+        y1 = lowpass.update(u, time);
+        y2 = notch.update(u, time);
+        error = std::max(error, std::abs(sum.update(u, time)(0) - y1(0) - y2(0)));
+        error = std::max(error, std::abs(difference.update(u, time)(0) - y1(0) + y2(0)));
+    }
+    BOOST_CHECK_SMALL(error, 1e-12);
+
+    // a chain runs as one filter
+    LinearSystem a(lowpass.getRealization()), b(notch.getRealization()), c(lag.getRealization());
+    LinearSystem chain = lag * notch * lowpass, fused = series(series(a, b), c);
+    BOOST_CHECK_EQUAL(chain.getOrder(), 5);
+    BOOST_CHECK_EQUAL(chain.getRealizationForm(), STATE_SPACE);
+    for (LinearSystem *sys : {&a, &b, &c, &chain, &fused})
+        sys->setInitialTime(0);
+    error = 0;
+    for (int k = 1; k <= 300; ++k)
+    {
+        u << std::cos(0.03 * k);
+        Time time = k * LinearSystem::getTimeFromSeconds(ts);
+        y1 = c.update(b.update(a.update(u, time).transpose(), time).transpose(), time);
+        error = std::max(error, std::abs(fused.update(u, time)(0) - y1(0)));
+        error = std::max(error, std::abs(chain.update(u, time)(0) - y1(0)));
+    }
+    BOOST_CHECK_SMALL(error, 1e-12);
+
+    // negative feedback through the notch: N1 D2 / (D1 D2 + N1 N2)
+    Eigen::VectorXd n1, d1, n2, d2, num, den;
+    lowpass.getCoefficients(n1, d1);
+    notch.getCoefficients(n2, d2);
+    feedback(lowpass, notch).getCoefficients(num, den);
+    Eigen::VectorXd expected_num(5), expected_den(5), product(5);
+    polynomial::multiply(n1, d2, expected_num);
+    polynomial::multiply(d1, d2, expected_den);
+    polynomial::multiply(n1, n2, product);
+    expected_den += product;
+    expected_num /= expected_den(0);
+    expected_den /= expected_den(0);
+    BOOST_CHECK_SMALL((num - expected_num).cwiseAbs().maxCoeff(), 1e-10);
+    BOOST_CHECK_SMALL((den - expected_den).cwiseAbs().maxCoeff(), 1e-10);
+
+    // H + H carries the states of H twice, which the reduction removes
+    LinearSystem twice = lowpass + lowpass, reduced = minimalRealization(twice);
+    BOOST_CHECK_EQUAL(twice.getOrder(), 4);
+    BOOST_CHECK_EQUAL(reduced.getOrder(), 2);
+    reduced.getCoefficients(num, den);
+    BOOST_CHECK_SMALL((num - 2 * n1).cwiseAbs().maxCoeff(), 1e-10);
+    BOOST_CHECK_SMALL((den - d1).cwiseAbs().maxCoeff(), 1e-10);
+    BOOST_CHECK_EQUAL(minimalRealization(chain).getOrder(), 5);
+
+    // state-space realizations can be converted to the other forms
+    std::shared_ptr<const DiscreteRealization> r = chain.getRealization();
+    DiscreteRealization canonical(r->getA(), r->getB(), r->getC(), r->getD(), ts, CONTROLLABLE_CANONICAL);
+    DiscreteRealization modal(r->getA(), r->getB(), r->getC(), r->getD(), ts, MODAL);
+    BOOST_CHECK_SMALL((canonical.getA().row(4).reverse().head(5) + r->getDenominator().tail(5).transpose()).cwiseAbs().maxCoeff(), 1e-10);
+    BOOST_CHECK_EQUAL(modal.getRealizationForm(), MODAL);
+
+    LinearSystem other_ts(Eigen::Vector2d(0, 1), Eigen::Vector2d(1, 1), 0.001, TUSTIN);
+    BOOST_CHECK_THROW(series(lowpass, other_ts), std::logic_error);
+    BOOST_CHECK_THROW(feedback(LinearSystem(Poly::Ones(1), Poly::Ones(1), ts), LinearSystem(Poly::Ones(1), Poly::Ones(1), ts), 1),
+                      std::logic_error);
+    BOOST_CHECK_THROW(LinearSystem(Eigen::Vector2d(0, 1), Eigen::Vector2d(1, 1), ts, TUSTIN, 0, STATE_SPACE), std::logic_error);
+    std::cout << std::endl;
+}
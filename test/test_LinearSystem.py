@@ -3,7 +3,7 @@ import yaml, unittest
 
 import sys
 sys.path.append('../build')
-from linear_system import LinearSystem, IntegrationMethod
+from linear_system import LinearSystem, IntegrationMethod, Decimator
 
 def initFilters(data):
     res = (LinearSystem(),LinearSystem(),LinearSystem())
@@ -97,5 +97,28 @@ class TestLinearSystem(unittest.TestCase):
             self.assertTrue(max_error < tolerance)
         print("")
 
+    def test_output_is_a_copy(self):
+        sys = LinearSystem(np.array([0.0, 1.0]), np.array([1.0, 1.0]), 0.01)
+        sys.setInitialTime(0)
+        sys.update(np.ones((1, 1)), 10000)
+        saved = sys.getOutput()
+        expected = saved.copy()
+        sys.update(np.ones((1, 1)), 20000)
+        self.assertTrue(np.array_equal(saved, expected))
+        self.assertFalse(np.array_equal(sys.getOutput(), expected))
+        # writing into the copy leaves the filter untouched
+        saved[0] = 1e6
+        self.assertNotEqual(sys.getOutput()[0], 1e6)
+
+    def test_decimator_output_is_a_copy(self):
+        dec = Decimator(LinearSystem(np.array([0.0, 1.0]), np.array([1.0, 1.0]), 0.01), 2)
+        self.assertTrue(dec.update(np.ones((1, 1))))
+        saved = dec.getOutput()
+        expected = saved.copy()
+        dec.update(np.ones((1, 1)))
+        self.assertTrue(dec.update(np.ones((1, 1))))
+        self.assertTrue(np.array_equal(saved, expected))
+        self.assertFalse(np.array_equal(dec.getOutput(), expected))
+
 if __name__ == "__main__":
     unittest.main()
\ No newline at end of file